@@ -77,6 +77,7 @@ int main(int argc, char *argv[]) {
     double stopTime      = 100.0;
     std::string protocol = "ns3::DashClient";
     std::string window   = "10s";
+    std::string scheduler = "Drr";
 
     // MpdFileHandler *mpd_instance = MpdFileHandler::getInstance();
 
@@ -112,6 +113,8 @@ int main(int argc, char *argv[]) {
       protocol);
     cmd.AddValue("window",
       "The window for measuring the average throughput (Time).", window);
+    cmd.AddValue("scheduler",
+      "The order in which the servers serve their clients: 'Fifo', 'Drr' or 'Edf'.", scheduler);
     cmd.Parse(argc, argv);
 
     std::string adj_mat_file_name ("src/dash/examples/adjacency_matrix_5_nodes.txt");
@@ -270,12 +273,14 @@ int main(int argc, char *argv[]) {
 
     DashServerHelper server("ns3::TcpSocketFactory",
         InetSocketAddress(Ipv4Address::GetAny(), port));
+    server.SetAttribute("Scheduler", StringValue(scheduler));
     ApplicationContainer serverApp = server.Install(nodes.Get(0));
     serverApp.Start(Seconds(0.0));
     serverApp.Stop(Seconds(stopTime + 5.0));
 
     DashServerHelper fogServer("ns3::TcpSocketFactory",
         InetSocketAddress(Ipv4Address::GetAny(), port));
+    fogServer.SetAttribute("Scheduler", StringValue(scheduler));
     ApplicationContainer fogServerApp = fogServer.Install(nodes.Get(layer));
     serverApp.Start(Seconds(0.0));
     serverApp.Stop(Seconds(stopTime + 5.0));
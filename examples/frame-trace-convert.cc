@@ -0,0 +1,61 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string>
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/dash-module.h"
+
+// Converts a text frame trace, with one "<bitrate> <type> <size>" line per
+// frame, to the binary trace that the SegmentCache "FrameTrace" attribute
+// maps:
+//
+//   ./waf --run "frame-trace-convert --input=frames.txt --output=frames.bin"
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "The text frame trace", input);
+  cmd.AddValue ("output", "The binary frame trace to write", output);
+  cmd.Parse (argc, argv);
+
+  if (input.empty () || output.empty ())
+    {
+      std::cerr << "Usage: frame-trace-convert --input=<text trace> --output=<binary trace>" << std::endl;
+      return 1;
+    }
+
+  if (!FrameTrace::Convert (input, output))
+    {
+      std::cerr << "Could not convert " << input << std::endl;
+      return 1;
+    }
+
+  Ptr<FrameTrace> trace = FrameTrace::Open (output);
+  for (uint32_t i = 0; i < trace->GetRepresentations (); i++)
+    {
+      std::cout << trace->GetBitrate (i) << " bps: "
+                << trace->GetFrames (trace->GetBitrate (i)) << " frames" << std::endl;
+    }
+  return 0;
+}
@@ -41,14 +41,8 @@ namespace ns3
   AaashClient::CalcNextSegment(uint32_t currRate, uint32_t & nextRate,
       Time & delay)
   {
-    uint32_t rates[] =
-    /*  { 13281, 18593, 26030, 36443, 51020, 71428, 100000, 140000, 195999,
-     274399, 384159, 537823 };*/
-      { 45000, 89000, 131000, 178000, 221000, 263000, 334000, 396000, 522000,
-          595000, 791000, 1033000, 1245000, 1547000, 2134000, 2484000, 3079000,
-          3527000, 3840000, 4220000 };
-
-    uint32_t rates_size = sizeof(rates) / sizeof(rates[0]);
+    Ptr<const BitrateLadder> ladder = GetLadder();
+    uint32_t rates_size = ladder->GetSize();
 
     double a1 = 0.75;
     double a2 = 0.33;
@@ -61,38 +55,20 @@ namespace ns3
     Time b_high("50s");
     Time b_opt = Seconds((b_low + b_high).GetSeconds() * 0.5);
 
-    Time taf(MilliSeconds(MPEG_FRAMES_PER_SEGMENT * MPEG_TIME_BETWEEN_FRAMES));
+    Time taf = GetTiming().GetSegmentDuration();
 
-    Time b_t = m_bufferState.rbegin()->second;
+    Time b_t = Seconds (m_bufferState.GetValue ());
     // std::cerr << "bt= " << b_t.GetSeconds() << std::endl;
 
-    uint32_t rateInd = rates_size;
-    for (uint32_t i = 0; i < rates_size; i++)
-      {
-        if (rates[i] == currRate)
-          {
-            rateInd = i;
-            break;
-          }
-      }
-    if (rateInd == rates_size)
-      {
-        NS_FATAL_ERROR("Wrong rate");
-      }
+    // The index of the current rate, or of the one below it if it is not
+    // on the ladder
+    uint32_t rateInd = ladder->GetIndex(currRate);
 
     nextRate = currRate;
     delay = Seconds(0);
 
-    uint32_t r_up = rates[rateInd];
-    uint32_t r_down = rates[rateInd];
-    if (rateInd + 1 < rates_size)
-      {
-        r_up = rates[rateInd + 1];
-      }
-    if (rateInd >= 1)
-      {
-        r_down = rates[rateInd - 1];
-      }
+    uint32_t r_up = ladder->GetRate(std::min(rateInd + 1, rates_size - 1));
+    uint32_t r_down = ladder->GetRate(rateInd > 0 ? rateInd - 1 : 0);
 
     /*std::cerr << "bufinc: " << BufferInc() << " FastStart: "
      << m_running_fast_start << std::endl;*/
@@ -130,18 +106,18 @@ namespace ns3
         m_running_fast_start = false;
         if (b_t < b_min)
           {
-            nextRate = rates[0];
+            nextRate = ladder->GetLowest();
           }
         else if (b_t < b_low)
           {
-            if (currRate != rates[0] && currRate >= m_bitrateEstimate)
+            if (currRate != ladder->GetLowest() && currRate >= m_bitrateEstimate)
               {
                 nextRate = r_down;
               }
           }
         else if (b_t < b_high)
           {
-            if ((currRate == rates[rates_size - 1])
+            if ((currRate == ladder->GetHighest())
                 || (r_up >= a5 * m_bitrateEstimate))
               {
                 delay = std::max(b_t - taf, b_opt);
@@ -149,7 +125,7 @@ namespace ns3
           }
         else
           {
-            if ((currRate == rates[rates_size - 1])
+            if ((currRate == ladder->GetHighest())
                 || (r_up >= a5 * m_bitrateEstimate))
               {
                 delay = std::max(b_t - taf, b_opt);
@@ -169,21 +145,7 @@ namespace ns3
   bool
   AaashClient::BufferInc()
   {
-    Time last(Seconds(0));
-    //std::cerr << "===" << std::endl;
-    for (std::map<Time, Time>::iterator it = m_bufferState.begin();
-        it != m_bufferState.end(); it++)
-      {
-        //  std::cerr << it->first.GetSeconds() << " " << it->second.GetSeconds()
-        //      << std::endl;
-
-        if (it->second < last)
-          {
-            return false;
-          }
-        last = it->second;
-      }
-    return true;
+    return m_bufferState.IsNonDecreasing () && m_bufferState.GetMin () >= 0;
   }
 
 } /* namespace ns3 */
@@ -114,26 +114,8 @@ namespace ns3
 
     result = output * m_bitrateEstimate;
 
-    uint32_t rates[] =
-    /*  { 13281, 18593, 26030, 36443, 51020, 71428, 100000, 140000, 195999,
-     274399, 384159, 537823 };*/
-      { 45000, 89000, 131000, 178000, 221000, 263000, 334000, 396000, 522000,
-          595000, 791000, 1033000, 1245000, 1547000, 2134000, 2484000, 3079000,
-          3527000, 3840000, 4220000 };
-
-    uint32_t rates_size = sizeof(rates) / sizeof(rates[0]);
-
-    uint32_t i;
-
-    nextRate = rates[0];
-
-    for (i = 0; i < rates_size; i++)
-      {
-        if (result > rates[i])
-          {
-            nextRate = rates[i];
-          }
-      }
+    // The highest rate strictly below the target one, result being whole
+    nextRate = GetLadder()->GetRateBelow(result - 1.0);
 
     delay = Seconds(0);
     if (nextRate > currRate)
@@ -40,33 +40,16 @@ namespace ns3
   OsmpClient::CalcNextSegment(uint32_t currRate, uint32_t & nextRate,
       Time & delay)
   {
-    uint32_t rates[] =
-      { 45000, 89000, 131000, 178000, 221000, 263000, 334000, 396000, 522000,
-          595000, 791000, 1033000, 1245000, 1547000, 2134000, 2484000, 3079000,
-          3527000, 3840000, 4220000 };
+    Ptr<const BitrateLadder> ladder = GetLadder();
+    uint32_t rates_size = ladder->GetSize();
 
-    uint32_t rates_size = sizeof(rates) / sizeof(rates[0]);
-
-    std::map<Time, Time>::iterator it;
-    it = m_bufferState.end();
-
-    it--;
-    Time now = it->first;
-
-    if (it != m_bufferState.begin())
-      {
-        it--;
-      }
+    Time now = m_bufferState.GetTime ();
 
     // The delivery time of the last fragment
-    Time t_last_frag = now - it->first;
+    Time t_last_frag = now - m_bufferState.GetTime (m_bufferState.GetCount () > 1 ? 1 : 0);
 
     // The current quality level
-    int l_cur = 0;
-    while (rates[l_cur] != currRate)
-      {
-        l_cur++;
-      }
+    int l_cur = ladder->GetIndex(currRate);
 
     int l_nxt = 0; // The next quality level
     int l_min = 0;  // The lowest quality level
@@ -75,18 +58,15 @@ namespace ns3
     double r_download = 100;
     if (t_last_frag.GetMilliSeconds() > 0)
       {
-        r_download = (1.0 * MPEG_FRAMES_PER_SEGMENT * MPEG_TIME_BETWEEN_FRAMES)
+        r_download = (1.0 * GetTiming().GetSegmentDuration().GetMilliSeconds())
             / t_last_frag.GetMilliSeconds();
       }
 
-    /*    std::cerr << "r_download: " << r_download << "\tratio: "
-     << ((1.0 * rates[l_cur - 1]) / rates[l_cur]) << std::endl;*/
-
     if (r_download < 1)
       {
         if (l_cur > l_min)
           {
-            if (r_download < ((1.0 * rates[l_cur - 1]) / rates[l_cur]))
+            if (r_download < ((1.0 * ladder->GetRate(l_cur - 1)) / ladder->GetRate(l_cur)))
               {
                 l_nxt = l_min;
               }
@@ -101,21 +81,21 @@ namespace ns3
         if (l_cur < l_max)
           {
             if (l_cur == 0
-                || r_download > ((1.0 * rates[l_cur - 1]) / rates[l_cur]))
+                || r_download > ((1.0 * ladder->GetRate(l_cur - 1)) / ladder->GetRate(l_cur)))
               {
                 do
                   {
                     l_nxt = l_nxt + 1;
                   }
                 while (!(l_nxt == l_max
-                    || r_download < ((1.0 * rates[l_nxt + 1]) / rates[l_cur])));
+                    || r_download < ((1.0 * ladder->GetRate(l_nxt + 1)) / ladder->GetRate(l_cur))));
               }
           }
       }
 
     // Pass the results back through the reference variables
     delay = Seconds(0);
-    nextRate = rates[l_nxt];
+    nextRate = ladder->GetRate(l_nxt);
 
   }
 
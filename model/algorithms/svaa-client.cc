@@ -41,12 +41,6 @@ namespace ns3
   SvaaClient::CalcNextSegment(uint32_t currRate, uint32_t & nextRate,
       Time & delay)
   {
-    uint32_t rates[] =
-      { 45000, 89000, 131000, 178000, 221000, 263000, 334000, 396000, 522000,
-          595000, 791000, 1033000, 1245000, 1547000, 2134000, 2484000, 3079000,
-          3527000, 3840000, 4220000 };
-
-    uint32_t rates_size = sizeof(rates) / sizeof(rates[0]);
     double diff = GetBufferDifferential();
 
     double q_tk = GetBufferEstimate();
@@ -54,7 +48,7 @@ namespace ns3
     double p = 1.0;
     double f_q = 2 * std::exp(p * (q_tk - q_ref))
         / (1 + std::exp(p * (q_tk - q_ref)));
-    double delta = MPEG_TIME_BETWEEN_FRAMES * MPEG_FRAMES_PER_SEGMENT / 1000.0;
+    double delta = GetTiming().GetSegmentDuration().GetSeconds();
     double f_t = delta / (delta - diff);
     double f_u = 1;
 
@@ -88,12 +82,7 @@ namespace ns3
 
     if (q_tk < q_ref / 2)
       {
-        int i = rates_size - 1;
-        while (rates[i] > t_k && i > 0)
-          {
-            i--;
-          }
-        nextRate = rates[i];
+        nextRate = GetLadder()->GetRateBelow(t_k);
         delay = Seconds(0);
         return;
       }
@@ -102,12 +91,7 @@ namespace ns3
         m_counter++;
         if (m_counter > m)
           {
-            int i = rates_size - 1;
-            while (rates[i] > t_k && i > 0)
-              {
-                i--;
-              }
-            nextRate = rates[i];
+            nextRate = GetLadder()->GetRateBelow(t_k);
             delay = Seconds(0);
             m_counter = 0;
             return;
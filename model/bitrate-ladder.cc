@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "bitrate-ladder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("BitrateLadder");
+
+    // The representations that the clients have always requested
+    static const uint32_t DEFAULT_RATES[] = { 45000, 89000, 131000, 178000, 221000, 263000,
+        334000, 396000, 522000, 595000, 791000, 1033000, 1245000, 1547000, 2134000, 2484000,
+        3079000, 3527000, 3840000, 4220000 };
+
+    std::map<uint32_t, Ptr<const BitrateLadder> > BitrateLadder::s_ladders;
+
+    BitrateLadder::BitrateLadder(const std::vector<uint32_t> &rates) :
+        m_rates(rates), m_maxStepUp(0), m_minStepDown(1) {
+        std::sort(m_rates.begin(), m_rates.end());
+        m_rates.erase(std::unique(m_rates.begin(), m_rates.end()), m_rates.end());
+        if (m_rates.empty() || m_rates[0] == 0) {
+            NS_FATAL_ERROR("A bitrate ladder needs at least one bitrate above zero");
+        }
+
+        m_stepUp.resize(m_rates.size(), std::numeric_limits<double>::max());
+        m_stepDown.resize(m_rates.size(), 1.0);
+        for (uint32_t i = 0; i + 1 < m_rates.size(); i++) {
+            m_stepUp[i] = (1.0 * m_rates[i + 1] - m_rates[i]) / m_rates[i];
+            m_stepDown[i + 1] = (1.0 * m_rates[i + 1] - m_rates[i]) / m_rates[i + 1];
+            m_maxStepUp = std::max(m_maxStepUp, m_stepUp[i]);
+            m_minStepDown = std::min(m_minStepDown, m_stepDown[i + 1]);
+        }
+    }
+
+    Ptr<const BitrateLadder> BitrateLadder::Get(uint32_t video_id) {
+        std::map<uint32_t, Ptr<const BitrateLadder> >::const_iterator it = s_ladders.find(video_id);
+        return it != s_ladders.end() ? it->second : GetDefault();
+    }
+
+    Ptr<const BitrateLadder> BitrateLadder::GetDefault(void) {
+        static Ptr<const BitrateLadder> ladder = Create<BitrateLadder>(std::vector<uint32_t>(
+            DEFAULT_RATES, DEFAULT_RATES + sizeof(DEFAULT_RATES) / sizeof(DEFAULT_RATES[0])));
+        return ladder;
+    }
+
+    void BitrateLadder::Set(uint32_t video_id, Ptr<const BitrateLadder> ladder) {
+        NS_LOG_FUNCTION(video_id << ladder);
+        if (ladder) {
+            s_ladders[video_id] = ladder;
+        } else {
+            s_ladders.erase(video_id);
+        }
+    }
+
+    bool BitrateLadder::Load(uint32_t video_id, const std::string &path) {
+        NS_LOG_FUNCTION(video_id << path);
+
+        std::ifstream in(path.c_str());
+        if (!in) {
+            NS_LOG_ERROR("Could not open " << path);
+            return false;
+        }
+
+        std::vector<uint32_t> rates;
+        std::string line;
+        uint32_t lineNo = 0;
+        while (std::getline(in, line)) {
+            lineNo++;
+            std::istringstream fields(line);
+            uint32_t rate;
+            fields >> std::ws;
+            if (fields.peek() == std::char_traits<char>::eof() || fields.peek() == '#') {
+                continue;
+            }
+            if (!(fields >> rate) || rate == 0) {
+                NS_LOG_ERROR(path << ":" << lineNo << ": expected a bitrate in bps");
+                return false;
+            }
+            rates.push_back(rate);
+        }
+        if (rates.empty()) {
+            NS_LOG_ERROR(path << " has no bitrates");
+            return false;
+        }
+
+        Set(video_id, Create<BitrateLadder>(rates));
+        return true;
+    }
+
+    uint32_t BitrateLadder::GetSize(void) const {
+        return m_rates.size();
+    }
+
+    uint32_t BitrateLadder::GetRate(uint32_t index) const {
+        NS_ASSERT(index < m_rates.size());
+        return m_rates[index];
+    }
+
+    uint32_t BitrateLadder::GetLowest(void) const {
+        return m_rates.front();
+    }
+
+    uint32_t BitrateLadder::GetHighest(void) const {
+        return m_rates.back();
+    }
+
+    uint32_t BitrateLadder::GetIndex(double rate) const {
+        // The first bitrate above the given one is right after the index
+        std::vector<uint32_t>::const_iterator it = std::upper_bound(m_rates.begin(), m_rates.end(), rate);
+        return it == m_rates.begin() ? 0 : (it - m_rates.begin()) - 1;
+    }
+
+    uint32_t BitrateLadder::GetRateBelow(double rate) const {
+        return m_rates[GetIndex(rate)];
+    }
+
+    uint32_t BitrateLadder::GetRateAbove(double rate) const {
+        std::vector<uint32_t>::const_iterator it = std::lower_bound(m_rates.begin(), m_rates.end(), rate);
+        return it == m_rates.end() ? m_rates.back() : *it;
+    }
+
+    double BitrateLadder::GetStepUp(uint32_t index) const {
+        NS_ASSERT(index < m_rates.size());
+        return m_stepUp[index];
+    }
+
+    double BitrateLadder::GetStepDown(uint32_t index) const {
+        NS_ASSERT(index < m_rates.size());
+        return m_stepDown[index];
+    }
+
+    double BitrateLadder::GetMaxStepUp(void) const {
+        return m_maxStepUp;
+    }
+
+    double BitrateLadder::GetMinStepDown(void) const {
+        return m_minStepDown;
+    }
+
+} // namespace ns3
@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef BITRATE_LADDER_H
+#define BITRATE_LADDER_H
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+    /**
+    * \ingroup dash
+    *
+    * \brief The bitrates in bps that a video is encoded at, from the lowest
+    * to the highest.
+    *
+    * A ladder is immutable once made, and shared by all the clients of its
+    * video. The lookups are binary searches, and the relative steps between
+    * neighbouring bitrates are computed once when the ladder is made.
+    */
+    class BitrateLadder : public SimpleRefCount<BitrateLadder>
+    {
+        public:
+            /**
+            * \param rates the bitrates, in any order. Duplicates are dropped.
+            */
+            BitrateLadder(const std::vector<uint32_t> &rates);
+
+            /**
+            * \return the ladder of the video, or the default one if none was
+            * set for it.
+            */
+            static Ptr<const BitrateLadder> Get(uint32_t video_id);
+
+            /**
+            * \return the ladder of the videos that have none of their own.
+            */
+            static Ptr<const BitrateLadder> GetDefault(void);
+
+            /**
+            * \brief Sets the ladder of a video, for the clients that start
+            * after the call. A null ladder restores the default one.
+            */
+            static void Set(uint32_t video_id, Ptr<const BitrateLadder> ladder);
+
+            /**
+            * \brief Reads the ladder of a video from a text file, with a
+            * bitrate in bps per line. Empty lines and the ones starting with
+            * '#' are skipped.
+            *
+            * \return false if the file could not be read, in which case the
+            * ladder of the video is left as it was.
+            */
+            static bool Load(uint32_t video_id, const std::string &path);
+
+            uint32_t GetSize(void) const;
+            uint32_t GetRate(uint32_t index) const;
+            uint32_t GetLowest(void) const;
+            uint32_t GetHighest(void) const;
+
+            /**
+            * \return the index of the highest bitrate that does not exceed
+            * rate, or 0 if they all do.
+            */
+            uint32_t GetIndex(double rate) const;
+
+            /**
+            * \return the highest bitrate that does not exceed rate, or the
+            * lowest one if they all do.
+            */
+            uint32_t GetRateBelow(double rate) const;
+
+            /**
+            * \return the lowest bitrate that is not below rate, or the
+            * highest one if they all are.
+            */
+            uint32_t GetRateAbove(double rate) const;
+
+            /**
+            * \return (r[i+1] - r[i]) / r[i], the relative increase to the next
+            * bitrate, or the largest double at the top of the ladder.
+            */
+            double GetStepUp(uint32_t index) const;
+
+            /**
+            * \return (r[i] - r[i-1]) / r[i], the relative decrease to the
+            * previous bitrate, or 1 at the bottom of the ladder.
+            */
+            double GetStepDown(uint32_t index) const;
+
+            double GetMaxStepUp(void) const;     // Over the whole ladder, 0 if it has one rate
+            double GetMinStepDown(void) const;   // Over the whole ladder, 1 if it has one rate
+
+        private:
+            std::vector<uint32_t> m_rates;
+            std::vector<double> m_stepUp;
+            std::vector<double> m_stepDown;
+            double m_maxStepUp;
+            double m_minStepDown;
+
+            static std::map<uint32_t, Ptr<const BitrateLadder> > s_ladders;  // Keyed by video id
+    };
+
+} // namespace ns3
+
+#endif /* BITRATE_LADDER_H */
@@ -6,13 +6,15 @@
 #include "ns3/socket-factory.h"
 #include <ns3/tcp-socket-factory.h>
 
-#include <ns3/random-variable-stream.h>
 #include <ns3/tcp-socket.h>
-#include <ns3/double.h>
+#include <ns3/pointer.h>
 
 #include "dash-server.h"
 #include "http-header.h"
 #include "mpeg-header.h"
+#include "segment-cache.h"
+#include "segment-cursor.h"
+#include "http-request-parser.h"
 
 namespace ns3
 {
@@ -35,6 +37,10 @@ namespace ns3
             .AddAttribute("window",
             "The window for measuring the average throughput (Time)",
             TimeValue(Time("10s")), MakeTimeAccessor(&CacheService::m_window), MakeTimeChecker())
+            .AddAttribute("SegmentCache",
+            "The cache of the synthesized segments. A private cache is created when it is not set.",
+            PointerValue(), MakePointerAccessor(&CacheService::m_cache),
+            MakePointerChecker<SegmentCache>())
             .AddTraceSource("Tx", "A new packet is created and is sent",
             MakeTraceSourceAccessor(&CacheService::m_txTrace), "ns3::Packet::TracedCallback");
         return tid;
@@ -66,6 +72,9 @@ namespace ns3
         NS_LOG_FUNCTION(this);
         m_socket = 0;
         m_socketList.clear();
+        m_cursors.clear();
+        m_parsers.clear();
+        m_cache = 0;
 
         // chain up
         Application::DoDispose();
@@ -73,6 +82,10 @@ namespace ns3
 
     void CacheService::StartApplication(void) {
         NS_LOG_FUNCTION(this);
+        if (!m_cache) {
+            m_cache = CreateObject<SegmentCache>();
+        }
+
         // Create the socket if not already
         if (!m_socket) {
             m_socket = Socket::CreateSocket(GetNode(), m_tid);
@@ -113,12 +126,6 @@ namespace ns3
             }
             m_totalRx += packet->GetSize();
 
-            HTTPHeader header;
-            packet->RemoveHeader(header);
-
-            SendSegment(header.GetVideoId(), header.GetResolution(),
-            header.GetSegmentId(), socket);
-
             if (InetSocketAddress::IsMatchingType(from)) {
                 NS_LOG_INFO(
                     "At time " << Simulator::Now ().GetSeconds () << "s packet sink received " << packet->GetSize () << " bytes from " << InetSocketAddress::ConvertFrom(from).GetIpv4 () << " port " << InetSocketAddress::ConvertFrom (from).GetPort () << " total Rx " << m_totalRx << " bytes");
@@ -127,15 +134,34 @@ namespace ns3
                     "At time " << Simulator::Now ().GetSeconds () << "s packet sink received " << packet->GetSize () << " bytes from " << Inet6SocketAddress::ConvertFrom(from).GetIpv6 () << " port " << Inet6SocketAddress::ConvertFrom (from).GetPort () << " total Rx " << m_totalRx << " bytes");
             }
             m_rxTrace(packet, from);
+
+            // A read may hold part of a request, or several pipelined ones
+            HttpRequestParser &parser = m_parsers[socket];
+            parser.Push(packet);
+
+            HTTPHeader header;
+            HTTPRequestHeader requestHeader;
+            while (parser.Next(header, requestHeader)) {
+                if (requestHeader.IsCancel()) {
+                    m_cursors[socket].Cancel(header.GetVideoId(), header.GetSegmentId());
+                    continue;
+                }
+                SendSegment(header.GetVideoId(), header.GetResolution(),
+                header.GetSegmentId(), requestHeader, socket);
+            }
         }
     }
 
     void CacheService::HandlePeerClose(Ptr<Socket> socket) {
         NS_LOG_FUNCTION(this << socket);
+        m_cursors.erase(socket);
+        m_parsers.erase(socket);
     }
 
     void CacheService::HandlePeerError(Ptr<Socket> socket) {
         NS_LOG_FUNCTION(this << socket);
+        m_cursors.erase(socket);
+        m_parsers.erase(socket);
     }
 
     void CacheService::HandleAccept(Ptr<Socket> s, const Address& from) {
@@ -151,24 +177,23 @@ namespace ns3
 
     void  CacheService::DataSend(Ptr<Socket> socket, uint32_t) {
         NS_LOG_FUNCTION(this);
-        for (std::map<Ptr<Socket>, std::queue<Packet> >::iterator iter = m_queues.begin(); iter != m_queues.end(); ++iter) {
-            HTTPHeader httpHeader;
-            MPEGHeader mpegHeader;
-
-            if (iter->second.size()) {
-                Ptr<Packet> frame = iter->second.front().Copy();
-
-                frame->RemoveHeader(mpegHeader);
-                frame->RemoveHeader(httpHeader);
-
+        for (std::map<Ptr<Socket>, SegmentCursor>::iterator iter = m_cursors.begin(); iter != m_cursors.end(); ++iter) {
+            if (!iter->second.IsEmpty()) {
                 NS_LOG_INFO(
-                "VidId: " << httpHeader.GetVideoId() << " rxAv= " << iter->first->GetRxAvailable() << " queue= "<< iter->second.size() << " res= " << httpHeader.GetResolution());
+                "VidId: " << iter->second.GetVideoId() << " rxAv= " << iter->first->GetRxAvailable() << " queue= "<< iter->second.GetPending() << " res= " << iter->second.GetResolution());
             }
         }
 
-        while (!m_queues[socket].empty()) {
+        SegmentCursor &cursor = m_cursors[socket];
+
+        // Frames are only made when the socket has room for them
+        while (!cursor.IsEmpty()) {
             int bytes;
-            Ptr<Packet> frame = m_queues[socket].front().Copy();
+            Ptr<Packet> frame = cursor.Peek(m_cache);
+            if (socket->GetTxAvailable() < frame->GetSize()) {
+                NS_LOG_INFO("Could not send frame");
+                break;
+            }
             if ((bytes = socket->Send(frame)) != (int) frame->GetSize()) {
                 NS_LOG_INFO("Could not send frame");
                 if (bytes != -1) {
@@ -176,53 +201,21 @@ namespace ns3
                 }
                 break;
             }
-            m_queues[socket].pop();
+            m_txTrace(frame);
+            cursor.Pop();
         }
 
         NS_LOG_INFO("DATA WAS JUST SENT!!!");
     }
 
-    void CacheService::SendSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id, Ptr<Socket> socket) {
-        int avg_packetsize = resolution / (50 * 8);
-
-        HTTPHeader http_header_tmp;
-        MPEGHeader mpeg_header_tmp;
-
-        Ptr<UniformRandomVariable> frame_size_gen = CreateObject<UniformRandomVariable> ();
-
-        frame_size_gen->SetAttribute ("Min", DoubleValue (0));
-        frame_size_gen->SetAttribute ("Max", DoubleValue (
-            std::max(
-            std::min(2 * avg_packetsize, MPEG_MAX_MESSAGE)
-            - (int) (mpeg_header_tmp.GetSerializedSize()
-            + http_header_tmp.GetSerializedSize()), 1)));
-
-        for (uint32_t f_id = 0; f_id < MPEG_FRAMES_PER_SEGMENT; f_id++) {
-            uint32_t frame_size = (unsigned) frame_size_gen->GetValue();
-
-            HTTPHeader http_header;
-            http_header.SetMessageType(HTTP_RESPONSE);
-            http_header.SetVideoId(video_id);
-            http_header.SetResolution(resolution);
-            http_header.SetSegmentId(segment_id);
-
-            MPEGHeader mpeg_header;
-            mpeg_header.SetFrameId(f_id);
-            mpeg_header.SetPlaybackTime(
-            MilliSeconds(
-            (f_id + (segment_id * MPEG_FRAMES_PER_SEGMENT))
-            * MPEG_TIME_BETWEEN_FRAMES)); //50 fps
-            mpeg_header.SetType('B');
-            mpeg_header.SetSize(frame_size);
-
-            Ptr<Packet> frame = Create<Packet>(frame_size);
-            frame->AddHeader(http_header);
-            frame->AddHeader(mpeg_header);
-                NS_LOG_INFO(
-                "SENDING PACKET " << f_id << " " << frame->GetSize() << " res=" << http_header.GetResolution() << " size=" << mpeg_header.GetSize() << " avg=" << avg_packetsize);
+    void CacheService::SendSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+        const HTTPRequestHeader &request, Ptr<Socket> socket) {
+        NS_LOG_INFO("SENDING SEGMENT " << segment_id << " res=" << resolution);
 
-            m_queues[socket].push(*frame);
-        }
+        // The frames are sent one response each, whatever the request asked,
+        // and the cached segment serves the ranges of it
+        m_cursors[socket].Push(video_id, resolution, segment_id, Time::Max(), false,
+            request.GetFirstFrame(), request.GetFrameCount());
         DataSend(socket, 0);
     }
 
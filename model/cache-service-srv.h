@@ -15,6 +15,10 @@
 #include <map>
 #include <queue>
 
+#include "segment-cache.h"
+#include "segment-cursor.h"
+#include "http-request-parser.h"
+
 
 namespace ns3
 {
@@ -55,7 +59,8 @@ namespace ns3
             void HandleRead(Ptr<Socket>);   // Called when a request is received
             void DataSend(Ptr<Socket>, uint32_t); // Called when a new segment is transmitted
                                      // or when new space is aveilable in the buffer
-            void SendSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id, Ptr<Socket> socket);  // Sends the segment back to the client
+            void SendSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+                const HTTPRequestHeader &request, Ptr<Socket> socket);  // Sends the segment, or the requested frames of it, back to the client
 
             void HandleAccept(Ptr<Socket>, const Address& from); // Called hen a new connection is accepted
             void HandlePeerClose(Ptr<Socket>); // Called when the connection is closed by the peer.
@@ -81,8 +86,13 @@ namespace ns3
             TracedCallback<Ptr<const Packet>, const Address &> m_rxTrace;
             TracedCallback<Ptr<const Packet> > m_txTrace;
 
-            // A structure that contains the generated MPEG frames, for each client.
-            std::map<Ptr<Socket>, std::queue<Packet>> m_queues;
+            // The segments requested by each client, and the next frame to send.
+            std::map<Ptr<Socket>, SegmentCursor> m_cursors;
+
+            // The partial requests received from each client.
+            std::map<Ptr<Socket>, HttpRequestParser> m_parsers;
+
+            Ptr<SegmentCache> m_cache;  // The frames of the recently requested segments
 
             Time m_window;
 
@@ -0,0 +1,228 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+#include "ns3/simulator.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "connection-pool.h"
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("ConnectionPool");
+
+    ConnectionPool::Endpoint::Endpoint() :
+        state(CLOSED), busy(false) {
+    }
+
+    ConnectionPool::ConnectionPool() :
+        m_initialBackoff(MilliSeconds(200)), m_maxBackoff(Seconds(10)), m_idleTimeout(Seconds(0)),
+        m_connects(0), m_failures(0) {
+    }
+
+    void ConnectionPool::SetNode(Ptr<Node> node, TypeId tid) {
+        m_node = node;
+        m_tid = tid;
+    }
+
+    void ConnectionPool::SetCallbacks(Callback<void, uint32_t> connected, Callback<void, uint32_t> lost,
+        Callback<void, Ptr<Socket> > recv) {
+        m_connected = connected;
+        m_lost = lost;
+        m_recv = recv;
+    }
+
+    void ConnectionPool::SetBackoff(Time initial, Time max) {
+        NS_ASSERT(initial > Seconds(0) && max >= initial);
+        m_initialBackoff = initial;
+        m_maxBackoff = max;
+    }
+
+    void ConnectionPool::SetIdleTimeout(Time timeout) {
+        m_idleTimeout = timeout;
+    }
+
+    uint32_t ConnectionPool::AddEndpoint(const Address &peer) {
+        Endpoint endpoint;
+        endpoint.peer = peer;
+        endpoint.backoff = m_initialBackoff;
+        m_endpoints.push_back(endpoint);
+        return m_endpoints.size() - 1;
+    }
+
+    uint32_t ConnectionPool::GetEndpoints(void) const {
+        return m_endpoints.size();
+    }
+
+    void ConnectionPool::Open(uint32_t endpoint) {
+        NS_LOG_FUNCTION(this << endpoint);
+        NS_ASSERT(endpoint < m_endpoints.size());
+        Endpoint &ep = m_endpoints[endpoint];
+        if (ep.state == CLOSED && !ep.retry.IsRunning()) {
+            Connect(endpoint);
+        }
+    }
+
+    void ConnectionPool::Connect(uint32_t endpoint) {
+        NS_LOG_FUNCTION(this << endpoint);
+        Endpoint &ep = m_endpoints[endpoint];
+
+        ep.socket = Socket::CreateSocket(m_node, m_tid);
+
+        // Fatal error if socket type is not NS3_SOCK_STREAM or NS3_SOCK_SEQPACKET
+        if (ep.socket->GetSocketType() != Socket::NS3_SOCK_STREAM
+            && ep.socket->GetSocketType() != Socket::NS3_SOCK_SEQPACKET) {
+            NS_FATAL_ERROR("Using HTTP with an incompatible socket type. "
+            "HTTP requires SOCK_STREAM or SOCK_SEQPACKET. "
+            "In other words, use TCP instead of UDP.");
+        }
+
+        if (Inet6SocketAddress::IsMatchingType(ep.peer)) {
+            ep.socket->Bind6();
+        } else if (InetSocketAddress::IsMatchingType(ep.peer)) {
+            ep.socket->Bind();
+        }
+
+        ep.socket->Connect(ep.peer);
+        ep.socket->SetRecvCallback(m_recv);
+        ep.socket->SetConnectCallback(
+            MakeCallback(&ConnectionPool::ConnectionSucceeded, this),
+            MakeCallback(&ConnectionPool::ConnectionFailed, this));
+        ep.socket->SetCloseCallbacks(
+            MakeCallback(&ConnectionPool::ConnectionFailed, this),
+            MakeCallback(&ConnectionPool::ConnectionFailed, this));
+        ep.state = CONNECTING;
+        m_connects++;
+    }
+
+    void ConnectionPool::Close(uint32_t endpoint) {
+        NS_LOG_FUNCTION(this << endpoint);
+        NS_ASSERT(endpoint < m_endpoints.size());
+        Endpoint &ep = m_endpoints[endpoint];
+        Simulator::Cancel(ep.retry);
+        Simulator::Cancel(ep.idle);
+        if (ep.socket) {
+            Ptr<Socket> socket = ep.socket;
+            Drop(endpoint);
+            socket->Close();
+        }
+    }
+
+    void ConnectionPool::CloseAll(void) {
+        for (uint32_t endpoint = 0; endpoint < m_endpoints.size(); endpoint++) {
+            Close(endpoint);
+        }
+    }
+
+    void ConnectionPool::Drop(uint32_t endpoint) {
+        Endpoint &ep = m_endpoints[endpoint];
+        ep.socket->SetConnectCallback(MakeNullCallback<void, Ptr<Socket> >(),
+            MakeNullCallback<void, Ptr<Socket> >());
+        ep.socket->SetCloseCallbacks(MakeNullCallback<void, Ptr<Socket> >(),
+            MakeNullCallback<void, Ptr<Socket> >());
+        ep.socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket> >());
+        ep.socket = 0;
+        ep.state = CLOSED;
+    }
+
+    ConnectionPool::State ConnectionPool::GetState(uint32_t endpoint) const {
+        return endpoint < m_endpoints.size() ? m_endpoints[endpoint].state : CLOSED;
+    }
+
+    bool ConnectionPool::IsReady(uint32_t endpoint) const {
+        return GetState(endpoint) == CONNECTED;
+    }
+
+    Ptr<Socket> ConnectionPool::GetSocket(uint32_t endpoint) const {
+        return endpoint < m_endpoints.size() ? m_endpoints[endpoint].socket : Ptr<Socket>(0);
+    }
+
+    void ConnectionPool::SetBusy(uint32_t endpoint, bool busy) {
+        NS_LOG_FUNCTION(this << endpoint << busy);
+        NS_ASSERT(endpoint < m_endpoints.size());
+        m_endpoints[endpoint].busy = busy;
+        if (busy) {
+            Simulator::Cancel(m_endpoints[endpoint].idle);
+        } else {
+            ArmIdle(endpoint);
+        }
+    }
+
+    void ConnectionPool::ArmIdle(uint32_t endpoint) {
+        Endpoint &ep = m_endpoints[endpoint];
+        Simulator::Cancel(ep.idle);
+        if (ep.state == CONNECTED && !ep.busy && m_idleTimeout > Seconds(0)) {
+            ep.idle = Simulator::Schedule(m_idleTimeout, &ConnectionPool::IdleExpired, this, endpoint);
+        }
+    }
+
+    void ConnectionPool::IdleExpired(uint32_t endpoint) {
+        NS_LOG_FUNCTION(this << endpoint);
+        NS_LOG_INFO("Closing the idle connection to endpoint " << endpoint);
+        Close(endpoint);
+    }
+
+    uint32_t ConnectionPool::GetConnects(void) const {
+        return m_connects;
+    }
+
+    uint32_t ConnectionPool::GetFailures(void) const {
+        return m_failures;
+    }
+
+    int ConnectionPool::Find(Ptr<Socket> socket) const {
+        for (uint32_t endpoint = 0; endpoint < m_endpoints.size(); endpoint++) {
+            if (m_endpoints[endpoint].socket == socket) {
+                return endpoint;
+            }
+        }
+        return -1;
+    }
+
+    void ConnectionPool::ConnectionSucceeded(Ptr<Socket> socket) {
+        NS_LOG_FUNCTION(this << socket);
+        int endpoint = Find(socket);
+        if (endpoint < 0) {
+            return;
+        }
+        Endpoint &ep = m_endpoints[endpoint];
+        ep.state = CONNECTED;
+        ep.backoff = m_initialBackoff;
+        ArmIdle(endpoint);
+        if (!m_connected.IsNull()) {
+            m_connected(endpoint);
+        }
+    }
+
+    void ConnectionPool::ConnectionFailed(Ptr<Socket> socket) {
+        NS_LOG_FUNCTION(this << socket);
+        int endpoint = Find(socket);
+        if (endpoint < 0) {
+            return;
+        }
+        Endpoint &ep = m_endpoints[endpoint];
+        NS_LOG_INFO("Connection to endpoint " << endpoint << " lost, retrying in " << ep.backoff);
+        m_failures++;
+        Simulator::Cancel(ep.idle);
+        Drop(endpoint);
+        socket->Close();
+
+        ep.retry = Simulator::Schedule(ep.backoff, &ConnectionPool::Connect, this, (uint32_t) endpoint);
+        ep.backoff = Min(ep.backoff + ep.backoff, m_maxBackoff);
+
+        if (!m_lost.IsNull()) {
+            m_lost(endpoint);
+        }
+    }
+
+    void ConnectionPool::Dispose(void) {
+        CloseAll();
+        m_endpoints.clear();
+        m_node = 0;
+        m_connected = MakeNullCallback<void, uint32_t>();
+        m_lost = MakeNullCallback<void, uint32_t>();
+        m_recv = MakeNullCallback<void, Ptr<Socket> >();
+    }
+
+} // namespace ns3
@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/address.h"
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/type-id.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+    class Node;
+    class Socket;
+
+    /**
+    * \ingroup dash
+    *
+    * \brief The TCP connections of a client to the endpoints it fetches its
+    * segments from, one per endpoint.
+    *
+    * A connection is opened ahead of the requests that need it. When it
+    * fails, or the peer closes it, it is opened again after a backoff that
+    * doubles on each failure, up to a maximum, and is reset by a successful
+    * handshake. A connection that carries no request for the idle timeout
+    * is closed, and opened again by the next Open ().
+    */
+    class ConnectionPool
+    {
+        public:
+            enum State
+            {
+                CLOSED,
+                CONNECTING,
+                CONNECTED
+            };
+
+            ConnectionPool();
+
+            /**
+            * \param node the node the sockets are made on.
+            * \param tid the socket factory, which must make stream sockets.
+            */
+            void SetNode(Ptr<Node> node, TypeId tid);
+
+            /**
+            * \param connected called with the endpoint once its connection is up.
+            * \param lost called with the endpoint when its connection failed
+            * or was closed by the peer, before the reconnection is scheduled.
+            * \param recv the receive callback of the sockets.
+            */
+            void SetCallbacks(Callback<void, uint32_t> connected, Callback<void, uint32_t> lost,
+                Callback<void, Ptr<Socket> > recv);
+
+            /**
+            * \param initial the wait before the first reconnection.
+            * \param max the longest wait, as the backoff doubles.
+            */
+            void SetBackoff(Time initial, Time max);
+
+            /**
+            * \param timeout the time without requests after which a connection
+            * is closed, zero to keep the connections open.
+            */
+            void SetIdleTimeout(Time timeout);
+
+            /**
+            * \return the index of the new endpoint, from 0 in the order they are added.
+            */
+            uint32_t AddEndpoint(const Address &peer);
+
+            uint32_t GetEndpoints(void) const;
+
+            /**
+            * \brief Connects to the endpoint, unless it is connected, connecting
+            * or waiting to reconnect.
+            */
+            void Open(uint32_t endpoint);
+
+            /**
+            * \brief Closes the connection, which is not opened again until Open ().
+            */
+            void Close(uint32_t endpoint);
+            void CloseAll(void);
+
+            State GetState(uint32_t endpoint) const;
+            bool IsReady(uint32_t endpoint) const;  // True if connected
+
+            /**
+            * \return the socket of the endpoint, connected or not, or 0 when
+            * it is closed.
+            */
+            Ptr<Socket> GetSocket(uint32_t endpoint) const;
+
+            /**
+            * \brief Tells whether requests are outstanding on the endpoint. The
+            * idle timeout only runs while they are not.
+            */
+            void SetBusy(uint32_t endpoint, bool busy);
+
+            uint32_t GetConnects(void) const;   // Handshakes started
+            uint32_t GetFailures(void) const;   // Connections failed or lost
+
+            /**
+            * \brief Closes the connections and forgets the node and callbacks.
+            */
+            void Dispose(void);
+
+        private:
+            struct Endpoint
+            {
+                Endpoint();
+
+                Address peer;
+                Ptr<Socket> socket;
+                State state;
+                bool busy;
+                Time backoff;       // Before the next reconnection
+                EventId retry;
+                EventId idle;
+            };
+
+            int Find(Ptr<Socket> socket) const;  // The endpoint of the socket, or -1
+            void Connect(uint32_t endpoint);
+            void ArmIdle(uint32_t endpoint);
+            void Drop(uint32_t endpoint);        // Forgets the socket, without callbacks
+            void ConnectionSucceeded(Ptr<Socket> socket);
+            void ConnectionFailed(Ptr<Socket> socket);
+            void IdleExpired(uint32_t endpoint);
+
+            std::vector<Endpoint> m_endpoints;
+            Ptr<Node> m_node;
+            TypeId m_tid;
+            Callback<void, uint32_t> m_connected;
+            Callback<void, uint32_t> m_lost;
+            Callback<void, Ptr<Socket> > m_recv;
+            Time m_initialBackoff;
+            Time m_maxBackoff;
+            Time m_idleTimeout;
+            uint32_t m_connects;
+            uint32_t m_failures;
+    };
+
+} // namespace ns3
+
+#endif /* CONNECTION_POOL_H */
@@ -20,13 +20,22 @@
 
 #include <ns3/log.h>
 #include <ns3/uinteger.h>
+#include <ns3/boolean.h>
 #include <ns3/tcp-socket-factory.h>
 #include <ns3/simulator.h>
 #include <ns3/inet-socket-address.h>
 #include <ns3/inet6-socket-address.h>
+#include <ns3/object-factory.h>
+#include <ns3/enum.h>
+#include <ns3/double.h>
 #include "http-header.h"
+#include "http-request-header.h"
+#include "mpd-file-handler.h"
 #include "dash-client.h"
 
+#include <algorithm>
+#include <cstdlib>
+
 NS_LOG_COMPONENT_DEFINE("DashClient");
 
 namespace ns3
@@ -51,8 +60,122 @@ namespace ns3
             MakeTimeAccessor(&DashClient::m_target_dt), MakeTimeChecker())
             .AddAttribute("window", "The window for measuring the average throughput (Time)",
             TimeValue(Time("10s")), MakeTimeAccessor(&DashClient::m_window),
-            MakeTimeChecker()).AddTraceSource("Tx", "A new packet is created and is sent",
-            MakeTraceSourceAccessor(&DashClient::m_txTrace), "ns3::Packet::TracedCallback");
+            MakeTimeChecker())
+            .AddAttribute("AnalyticPlayback",
+            "Plays the frames lazily, scheduling events only when the buffer runs out "
+            "and when a buffer wakeup is due, instead of one event per frame. "
+            "The playback statistics are the same.",
+            BooleanValue(false), MakeBooleanAccessor(&DashClient::m_analyticPlayback),
+            MakeBooleanChecker())
+            .AddAttribute("SegmentResponses",
+            "Asks the server for one response per segment, with an index of its frames, "
+            "instead of one response per frame. The bytes on the wire are the same.",
+            BooleanValue(false), MakeBooleanAccessor(&DashClient::m_segmentResponses),
+            MakeBooleanChecker())
+            .AddAttribute("PipelineDepth",
+            "The number of segment requests that may be outstanding. With 1 the next segment is "
+            "requested once the previous one is received; with more, the following segments are "
+            "requested while the current one downloads, at the bitrate decided at that point.",
+            UintegerValue(1), MakeUintegerAccessor(&DashClient::m_pipelineDepth),
+            MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("Connections",
+            "The number of TCP connections to the server. Each segment is split in frame ranges, "
+            "one per connected connection, and the frames are put back in order for the player. "
+            "Whole segment responses are only used with a single connection.",
+            UintegerValue(1), MakeUintegerAccessor(&DashClient::m_connections),
+            MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("EdgeSelection",
+            "How the client chooses between the server (Remote) and the fog node (FogRemote). "
+            "Dynamic fetches each segment from the endpoint with the shortest predicted fetch "
+            "time, and FixedSegment moves to the fog node for good from segment 20.",
+            EnumValue(DashClient::DYNAMIC_EDGE), MakeEnumAccessor(&DashClient::m_edgeSelection),
+            MakeEnumChecker(DashClient::DYNAMIC_EDGE, "Dynamic",
+            DashClient::FIXED_SEGMENT_EDGE, "FixedSegment"))
+            .AddAttribute("EdgeMargin",
+            "The relative improvement of the predicted segment fetch time that another "
+            "endpoint must offer for the client to switch to it.",
+            DoubleValue(0.1), MakeDoubleAccessor(&DashClient::m_edgeMargin),
+            MakeDoubleChecker<double>(0, 1))
+            .AddAttribute("ProbeFrames",
+            "The number of frames of the lowest bitrate that an endpoint without recent "
+            "statistics is asked for, to measure its round trip time and throughput.",
+            UintegerValue(10), MakeUintegerAccessor(&DashClient::m_probeFrames),
+            MakeUintegerChecker<uint32_t>(2))
+            .AddAttribute("ProbeInterval",
+            "The age of the statistics of an endpoint after which it is probed again.",
+            TimeValue(Seconds(10)), MakeTimeAccessor(&DashClient::m_probeInterval),
+            MakeTimeChecker())
+            .AddAttribute("IdleTimeout",
+            "The time without requests after which the connection to an endpoint is closed. "
+            "It is opened again when a request or a probe needs it. Zero keeps the connections open.",
+            TimeValue(Seconds(60)), MakeTimeAccessor(&DashClient::m_idleTimeout),
+            MakeTimeChecker())
+            .AddAttribute("ReconnectBackoff",
+            "The wait before connecting again to an endpoint whose connection failed or was closed. "
+            "It doubles on each failure, and is reset by a successful handshake.",
+            TimeValue(MilliSeconds(200)), MakeTimeAccessor(&DashClient::m_reconnectBackoff),
+            MakeTimeChecker(MilliSeconds(1)))
+            .AddAttribute("MaxReconnectBackoff",
+            "The longest wait before connecting again to an endpoint.",
+            TimeValue(Seconds(10)), MakeTimeAccessor(&DashClient::m_maxReconnectBackoff),
+            MakeTimeChecker(MilliSeconds(1)))
+            .AddAttribute("AbandonRequests",
+            "Cancels the request of a segment whose remaining frames are predicted to arrive "
+            "after the player needs them, and requests them again at a lower bitrate. "
+            "Not used with whole segment responses or with several connections.",
+            BooleanValue(false), MakeBooleanAccessor(&DashClient::m_abandon),
+            MakeBooleanChecker())
+            .AddAttribute("AbandonMinFrames",
+            "The frames of a segment to receive before its request may be abandoned.",
+            UintegerValue(5), MakeUintegerAccessor(&DashClient::m_abandonMinFrames),
+            MakeUintegerChecker<uint32_t>(2))
+            .AddAttribute("ChunkFrames",
+            "Requests each segment in chunks of this many frames, as frame ranges. The next chunk "
+            "is requested halfway through the current one, at the highest bitrate up to the one "
+            "decided for the segment that the measured throughput sustains. Zero requests whole "
+            "segments. Not used with whole segment responses or with several connections.",
+            UintegerValue(0), MakeUintegerAccessor(&DashClient::m_chunkFrames),
+            MakeUintegerChecker<uint32_t>())
+            .AddAttribute("ReadSamples",
+            "The number of socket reads that are kept, as (bytes, interval) samples, for the "
+            "adaptation algorithms. The oldest ones are dropped.",
+            UintegerValue(64), MakeUintegerAccessor(&DashClient::m_readSamples),
+            MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("TransportColdStart",
+            "On a switch of endpoint, starts the throughput estimate over from the congestion "
+            "window per round trip of the TCP connection to the new one, when its traces have "
+            "given both, instead of from the segments received from the previous one.",
+            BooleanValue(true), MakeBooleanAccessor(&DashClient::m_transportColdStart),
+            MakeBooleanChecker())
+            .AddAttribute("ThroughputEstimator",
+            "The type of ThroughputEstimator that the segment bitrates are fed to. "
+            "If it has a Window attribute, it is set to the window of the client.",
+            TypeIdValue(MeanThroughputEstimator::GetTypeId()),
+            MakeTypeIdAccessor(&DashClient::m_estimatorTid), MakeTypeIdChecker())
+            .AddTraceSource("Tx", "A new packet is created and is sent",
+            MakeTraceSourceAccessor(&DashClient::m_txTrace), "ns3::Packet::TracedCallback")
+            .AddTraceSource("SegmentReceived", "A segment has been fully received",
+            MakeTraceSourceAccessor(&DashClient::m_segmentReceivedTrace),
+            "ns3::DashClient::SegmentReceivedTracedCallback")
+            .AddTraceSource("EdgeSelected",
+            "The endpoint of the next segment has been chosen between the current one and another one",
+            MakeTraceSourceAccessor(&DashClient::m_edgeSelectedTrace),
+            "ns3::DashClient::EdgeSelectedTracedCallback")
+            .AddTraceSource("HandshakeStall",
+            "A request has waited this long for the handshake of its endpoint",
+            MakeTraceSourceAccessor(&DashClient::m_handshakeStallTrace),
+            "ns3::Time::TracedCallback")
+            .AddTraceSource("RequestAbandoned",
+            "The remaining frames of a segment have been requested again at a lower bitrate",
+            MakeTraceSourceAccessor(&DashClient::m_requestAbandonedTrace),
+            "ns3::DashClient::RequestAbandonedTracedCallback")
+            .AddTraceSource("ReadSample", "Bytes have been read from a socket of the client",
+            MakeTraceSourceAccessor(&DashClient::m_readTrace),
+            "ns3::DashClient::ReadSampleTracedCallback")
+            .AddTraceSource("EstimateSeeded",
+            "The throughput estimate has started over from the connection to a new endpoint",
+            MakeTraceSourceAccessor(&DashClient::m_estimateSeededTrace),
+            "ns3::DashClient::EstimateSeededTracedCallback");
 
         return tid;
     }
@@ -62,9 +185,17 @@ namespace ns3
           m_socket(0), m_connected(false), m_totBytes(0), m_startedReceiving(
           Seconds(0)), m_sumDt(Seconds(0)), m_lastDt(Seconds(-1)), m_id(
           m_countObjs++), m_requestTime("0s"), m_segment_bytes(0), m_bitRate(
-          45000), m_window(Seconds(10)), m_segmentFetchTime(Seconds(0)),  m_segment_total(1000) {
+          45000), m_window(Seconds(10)), m_segmentFetchTime(Seconds(0)),  m_segment_total(1000),
+          m_analyticPlayback(false), m_segmentResponses(false), m_pipelineDepth(1),
+          m_firstRequest(Seconds(-1)), m_lastSegment(Seconds(0)), m_connections(1), m_nextFrame(0),
+          m_edgeSelection(DYNAMIC_EDGE), m_edgeMargin(0.1), m_probeFrames(10), m_probeInterval(Seconds(10)),
+          m_probing(false), m_idleTimeout(Seconds(60)), m_reconnectBackoff(MilliSeconds(200)),
+          m_maxReconnectBackoff(Seconds(10)), m_stallStart(Seconds(-1)), m_handshakeStall(Seconds(0)),
+          m_abandon(false), m_abandonMinFrames(5), m_chunkFrames(0),
+          m_readSamples(64), m_transportColdStart(true), m_requestEdge(CLOUD_EDGE) {
         NS_LOG_FUNCTION(this);
         m_parser.SetApp(this); // So the parser knows where to send the received messages
+        m_fogParser.SetApp(this);
     }
 
     DashClient::~DashClient() {
@@ -79,7 +210,16 @@ namespace ns3
     void DashClient::DoDispose(void) {
         NS_LOG_FUNCTION(this);
 
+        for (uint32_t edge = CLOUD_EDGE; edge <= FOG_EDGE; edge++) {
+            Unmonitor(edge);
+        }
+        m_pool.Dispose();
         m_socket = 0;
+        m_fog_socket = 0;
+        m_subflows.clear();
+        m_reorder.clear();
+        m_estimator = 0;
+        m_ladder = 0;
         // chain up
         Application::DoDispose();
     }
@@ -88,34 +228,63 @@ namespace ns3
     void DashClient::StartApplication(void) { // Called at time specified by Start
         NS_LOG_FUNCTION(this);
 
-        // Create the socket if not already
-        NS_LOG_INFO("trying to create connection");
-        if (!m_socket) {
-            NS_LOG_INFO("Just created connection");
-            m_socket = Socket::CreateSocket(GetNode(), m_tid);
+        m_player.SetAnalytic(m_analyticPlayback);
+        m_reads.SetCapacity(m_readSamples);
+        m_bitRate = GetLadder()->GetLowest();
+        m_timing = VideoTiming::Get(m_videoId);
+        m_player.SetFrameInterval(m_timing.GetFrameInterval());
+
+        // The manifest of the video, if it has one, tells how long it is
+        Ptr<const MpdManifest> manifest = MpdFileHandler::getInstance()->Get(m_videoId);
+        if (manifest && manifest->GetSegmentCount() > 0) {
+            m_segment_total = manifest->GetSegmentCount();
+        }
 
-            // Fatal error if socket type is not NS3_SOCK_STREAM or NS3_SOCK_SEQPACKET
-            if (m_socket->GetSocketType() != Socket::NS3_SOCK_STREAM
-                && m_socket->GetSocketType() != Socket::NS3_SOCK_SEQPACKET) {
-                NS_FATAL_ERROR("Using HTTP with an incompatible socket type. "
-                "HTTP requires SOCK_STREAM or SOCK_SEQPACKET. "
-                "In other words, use TCP instead of UDP.");
+        // Both endpoints are connected ahead of the requests that need them
+        NS_LOG_INFO("trying to create connection");
+        m_pool.SetNode(GetNode(), m_tid);
+        m_pool.SetCallbacks(MakeCallback(&DashClient::EndpointConnected, this),
+            MakeCallback(&DashClient::EndpointLost, this),
+            MakeCallback(&DashClient::HandleRead, this));
+        m_pool.SetBackoff(m_reconnectBackoff, m_maxReconnectBackoff);
+        m_pool.SetIdleTimeout(m_idleTimeout);
+        if (m_pool.GetEndpoints() == 0) {
+            m_pool.AddEndpoint(m_peer); // CLOUD_EDGE
+            if (InetSocketAddress::IsMatchingType(m_fog_peer)
+                || Inet6SocketAddress::IsMatchingType(m_fog_peer)) {
+                m_pool.AddEndpoint(m_fog_peer); // FOG_EDGE
             }
+        }
+        for (uint32_t edge = 0; edge < m_pool.GetEndpoints(); edge++) {
+            m_pool.Open(edge);
+        }
+        SyncSockets();
+        target_socket = &m_socket;
 
+        // The other connections to the server, that share the segments
+        if (m_subflows.empty()) {
+            m_subflows.resize(m_connections - 1);
+        }
+        for (std::vector<Subflow>::iterator it = m_subflows.begin(); it != m_subflows.end(); ++it) {
+            if (it->socket) {
+                continue;
+            }
+            it->socket = Socket::CreateSocket(GetNode(), m_tid);
             if (Inet6SocketAddress::IsMatchingType(m_peer)) {
-                m_socket->Bind6();
+                it->socket->Bind6();
             } else if (InetSocketAddress::IsMatchingType(m_peer)) {
-                m_socket->Bind();
+                it->socket->Bind();
             }
-
-            m_socket->Connect(m_peer);
-            m_socket->SetRecvCallback(MakeCallback(&DashClient::HandleRead, this));
-            m_socket->SetConnectCallback(
-                MakeCallback(&DashClient::ConnectionSucceeded, this),
+            it->socket->Connect(m_peer);
+            it->socket->SetRecvCallback(MakeCallback(&DashClient::HandleRead, this));
+            it->socket->SetConnectCallback(
+                MakeCallback(&DashClient::SubflowSucceeded, this),
                 MakeCallback(&DashClient::ConnectionFailed, this));
-            m_socket->SetSendCallback(MakeCallback(&DashClient::DataSend, this));
+            it->parser.SetApp(this);
+            it->connected = false;
         }
-        target_socket = &m_socket;
+
+        m_edges.SetMargin(m_edgeMargin);
 
         Address addr;
         m_socket->GetSockName (addr);
@@ -129,13 +298,16 @@ namespace ns3
     void DashClient::StopApplication(void) { // Called at time specified by Stop
         NS_LOG_FUNCTION(this);
 
-        if (m_socket != 0) {
-            m_socket->Close();
-            m_connected = false;
-            m_player.m_state = MPEG_PLAYER_DONE;
-        } else {
-            NS_LOG_WARN("DashClient found null socket to close in StopApplication");
+        m_pool.CloseAll();
+        SyncSockets();
+
+        for (std::vector<Subflow>::iterator it = m_subflows.begin(); it != m_subflows.end(); ++it) {
+            it->socket->Close();
+            it->connected = false;
         }
+
+        m_connected = false;
+        m_player.Stop();
     }
 
     // Private helpers
@@ -147,41 +319,193 @@ namespace ns3
             return;
         }
 
+        if (m_pending.size() >= m_pipelineDepth) { // A prefetch took the place of a delayed request
+            return;
+        }
+
+        // The server answers in order, so the segment waits until the last
+        // chunk of the one before it is requested, which prefetches it
+        if (ChunksPending()) {
+            return;
+        }
+
         if(m_segmentId == m_segment_total){
-            m_player.setEndPlayer(true);
+            if (m_pending.empty()) {
+                m_player.setEndPlayer(true);
+            }
             return;
         }
 
-        Ptr<Packet> packet = Create<Packet>(100);
+        if (m_edgeSelection == DYNAMIC_EDGE) {
+            SelectEdge();
+        }
+
+        // The request waits for the handshake of its endpoint, unless the
+        // other one is free to take it
+        if (!m_pool.IsReady(GetEdge())) {
+            uint32_t other = GetEdge() == FOG_EDGE ? CLOUD_EDGE : FOG_EDGE;
+            if (m_edgeSelection == DYNAMIC_EDGE && m_pool.IsReady(other)) {
+                target_socket = other == FOG_EDGE ? &m_fog_socket : &m_socket;
+            } else {
+                if (m_stallStart < Seconds(0)) {
+                    m_stallStart = Simulator::Now();
+                }
+                m_pool.Open(GetEdge());
+                SyncSockets();
+                return;
+            }
+        }
+        if (m_stallStart >= Seconds(0)) {
+            Time stall = Simulator::Now() - m_stallStart;
+            m_handshakeStall += stall;
+            m_stallStart = Seconds(-1);
+            m_handshakeStallTrace(stall);
+        }
+
+        // The segments of the previous endpoint say little of the new one,
+        // whose connection tells the rate it would carry without waiting
+        // for a segment
+        if (GetEdge() != m_requestEdge) {
+            m_requestEdge = GetEdge();
+            if (m_transportColdStart && m_transport[m_requestEdge].HasData()) {
+                NS_LOG_INFO("Estimate of edge " << m_requestEdge << " starts from its connection, at "
+                    << m_transport[m_requestEdge].GetBandwidthEstimate() << " bps");
+                m_bitrates.Clear();
+                m_estimator = 0;
+                AddBitRate(Simulator::Now(), m_transport[m_requestEdge].GetBandwidthEstimate());
+                m_estimateSeededTrace(m_requestEdge, m_transport[m_requestEdge].GetBandwidthEstimate());
+            }
+        }
+
+        // The connections the segment is split across
+        std::vector<Ptr<Socket> > sockets(1, *target_socket);
+        if (target_socket == &m_socket) {
+            for (std::vector<Subflow>::iterator it = m_subflows.begin(); it != m_subflows.end(); ++it) {
+                if (it->connected) {
+                    sockets.push_back(it->socket);
+                }
+            }
+        }
+        uint32_t frames = m_timing.GetFramesPerSegment();
+        uint32_t parts = std::min<uint32_t>(sockets.size(), frames);
+        bool chunked = m_chunkFrames > 0 && m_chunkFrames < frames && parts == 1 && !m_segmentResponses;
+        uint32_t chunkEnd = chunked ? m_chunkFrames : frames;
+
+        for (uint32_t part = 0; part < parts; part++) {
+            HTTPRequestHeader requestHeader = MakeRequestHeader(m_segmentId);
+            if (parts > 1) { // Consecutive frames on each connection
+                uint32_t first = part * frames / parts;
+                requestHeader.SetFrameRange(first, (part + 1) * frames / parts - first);
+            } else if (chunked) {
+                requestHeader.SetFrameRange(0, chunkEnd);
+            } else {
+                requestHeader.SetWholeSegment(m_segmentResponses);
+            }
+
+            if (!SendRequest(sockets[part], m_segmentId, m_bitRate, requestHeader)) {
+                NS_FATAL_ERROR("Oh oh. Couldn't send the request of segment " << m_segmentId);
+            }
+        }
+
+        // A pipelined segment starts downloading when the ones before it are received
+        if (m_pending.empty()) {
+            m_requestTime = Simulator::Now();
+            m_segment_bytes = 0;
+        }
+        if (m_firstRequest < Seconds(0)) {
+            m_firstRequest = Simulator::Now();
+        }
+        PendingSegment pending = { m_segmentId++, m_bitRate, Simulator::Now(), GetEdge(), false, parts > 1,
+            0, chunkEnd, m_bitRate };
+        m_pending.push_back(pending);
+        m_pool.SetBusy(GetEdge(), true);
+
+        // The fog connection is made while the last segments of the server
+        // download, ready for the switch, even if it was idle until now
+        if (m_edgeSelection == FIXED_SEGMENT_EDGE && m_segmentId == 20 && m_pool.GetEndpoints() > FOG_EDGE) {
+            m_pool.Open(FOG_EDGE);
+            SyncSockets();
+        }
+    }
+
+    HTTPRequestHeader DashClient::MakeRequestHeader(uint32_t segment_id) {
+        HTTPRequestHeader requestHeader;
+        if (m_player.m_state == MPEG_PLAYER_PLAYING || m_player.m_state == MPEG_PLAYER_PAUSED) {
+            // The first frame of the requested segment plays after the buffered ones
+            Time bufferLevel = Max(Seconds(0), m_player.GetRealPlayTime(
+                m_timing.GetPlaybackTime(segment_id, 0)));
+            requestHeader.SetBufferLevel(bufferLevel);
+            requestHeader.SetDeadline(Simulator::Now() + bufferLevel);
+        }
+        return requestHeader;
+    }
+
+    bool DashClient::SendRequest(Ptr<Socket> socket, uint32_t segment_id, uint32_t bitRate,
+        const HTTPRequestHeader &requestHeader) {
+        Ptr<Packet> packet = Create<Packet>(HTTP_REQUEST_BODY - requestHeader.GetSerializedSize());
+        packet->AddHeader(requestHeader);
 
         HTTPHeader httpHeader;
         httpHeader.SetSeq(1);
         httpHeader.SetMessageType(HTTP_REQUEST);
         httpHeader.SetVideoId(m_videoId);
-        httpHeader.SetResolution(m_bitRate);
-        httpHeader.SetSegmentId(m_segmentId++);
+        httpHeader.SetResolution(bitRate);
+        httpHeader.SetSegmentId(segment_id);
         packet->AddHeader(httpHeader);
 
-        int res = 0;
-        if (((unsigned) (res = (*target_socket)->Send(packet))) != packet->GetSize()) {
-            NS_FATAL_ERROR(
-                "Oh oh. Couldn't send packet! res=" << res << " size=" << packet->GetSize());
+        int res = socket->Send(packet);
+        if (res != (int) packet->GetSize()) {
+            NS_LOG_WARN("Couldn't send packet! res=" << res << " size=" << packet->GetSize());
+            return false;
         }
+        m_txTrace(packet);
+        return true;
+    }
 
-        m_requestTime = Simulator::Now();
-        m_segment_bytes = 0;
+    void DashClient::Prefetch() {
+        NS_LOG_FUNCTION(this);
+
+        // Not past a switch to the fog node, which waits for the requests
+        // already sent on the other socket, nor ahead of the chunks of the
+        // last segment, which the server would send after it
+        while (m_connected && m_pending.size() < m_pipelineDepth && m_segmentId < m_segment_total
+            && !FogSwitchDue() && m_stallStart < Seconds(0) && !ChunksPending()) {
+            uint32_t nextRate;
+            Time bufferDelay;
+            CalcNextSegment(m_bitRate, nextRate, bufferDelay);
+            if (bufferDelay > Seconds(0)) { // Decided again when the current segment is received
+                break;
+            }
+            if (nextRate != m_bitRate) {
+                m_rateChanges++;
+            }
+            m_bitRate = nextRate;
+            RequestSegment();
+        }
     }
 
     void DashClient::HandleRead(Ptr<Socket> socket) {
         NS_LOG_FUNCTION(this << socket);
-        m_parser.ReadSocket(socket);
+        for (std::vector<Subflow>::iterator it = m_subflows.begin(); it != m_subflows.end(); ++it) {
+            if (it->socket == socket) {
+                it->parser.ReadSocket(socket);
+                return;
+            }
+        }
+        if (socket == m_fog_socket) {
+            m_fogParser.ReadSocket(socket);
+        } else {
+            m_parser.ReadSocket(socket);
+        }
     }
 
-    void DashClient::ConnectionSucceeded(Ptr<Socket> socket) {
+    void DashClient::SubflowSucceeded(Ptr<Socket> socket) {
         NS_LOG_FUNCTION(this << socket);
-        NS_LOG_LOGIC("DashClient Connection succeeded");
-        m_connected = true;
-        RequestSegment();
+        for (std::vector<Subflow>::iterator it = m_subflows.begin(); it != m_subflows.end(); ++it) {
+            if (it->socket == socket) {
+                it->connected = true; // Takes its part of the next requests
+            }
+        }
     }
 
     void DashClient::ConnectionFailed(Ptr<Socket> socket) {
@@ -189,34 +513,201 @@ namespace ns3
             "DashClient, Connection Failed");
     }
 
-    void DashClient::DataSend(Ptr<Socket>, uint32_t) {
-        NS_LOG_FUNCTION(this);
+    void DashClient::SyncSockets() {
+        m_socket = m_pool.GetSocket(CLOUD_EDGE);
+        m_fog_socket = m_pool.GetSocket(FOG_EDGE);
+        for (uint32_t edge = CLOUD_EDGE; edge < m_pool.GetEndpoints() && edge <= FOG_EDGE; edge++) {
+            if (m_pool.GetSocket(edge) != m_monitored[edge]) {
+                Unmonitor(edge);
+                Monitor(edge);
+            }
+        }
+    }
 
-        if (m_connected) { // Only send new data if the connection has completed
-            NS_LOG_INFO("Something was sent");
-        } else {
-            NS_LOG_INFO("NOT CONNECTED!!!!");
+    void DashClient::Monitor(uint32_t edge) {
+        NS_LOG_FUNCTION(this << edge);
+        Ptr<Socket> socket = m_pool.GetSocket(edge);
+        if (!socket) {
+            return;
+        }
+        m_monitored[edge] = socket;
+        m_transport[edge].Reset();
+
+        // A socket of another protocol has none of these traces
+        std::string context(1, '0' + edge);
+        if (!socket->TraceConnect("RTT", context, MakeCallback(&DashClient::TcpRttChanged, this))) {
+            NS_LOG_WARN("The socket of edge " << edge << " has no TCP traces");
+            return;
+        }
+        socket->TraceConnect("CongestionWindow", context, MakeCallback(&DashClient::TcpCwndChanged, this));
+        socket->TraceConnect("CongState", context, MakeCallback(&DashClient::TcpCongStateChanged, this));
+
+        // The window is only traced once it grows from its initial value
+        UintegerValue initialCwnd;
+        UintegerValue segmentSize;
+        if (socket->GetAttributeFailSafe("InitialCwnd", initialCwnd)
+            && socket->GetAttributeFailSafe("SegmentSize", segmentSize)) {
+            m_transport[edge].SetCwnd(initialCwnd.Get() * segmentSize.Get());
         }
     }
 
-    void DashClient::MessageReceived(Packet message) {
-        NS_LOG_FUNCTION(this << message);
+    void DashClient::Unmonitor(uint32_t edge) {
+        if (!m_monitored[edge]) {
+            return;
+        }
+        std::string context(1, '0' + edge);
+        m_monitored[edge]->TraceDisconnect("RTT", context, MakeCallback(&DashClient::TcpRttChanged, this));
+        m_monitored[edge]->TraceDisconnect("CongestionWindow", context,
+            MakeCallback(&DashClient::TcpCwndChanged, this));
+        m_monitored[edge]->TraceDisconnect("CongState", context,
+            MakeCallback(&DashClient::TcpCongStateChanged, this));
+        m_monitored[edge] = 0;
+    }
+
+    void DashClient::TcpRttChanged(std::string context, Time oldRtt, Time newRtt) {
+        m_transport[std::atoi(context.c_str())].AddRtt(newRtt);
+    }
+
+    void DashClient::TcpCwndChanged(std::string context, uint32_t oldCwnd, uint32_t newCwnd) {
+        m_transport[std::atoi(context.c_str())].SetCwnd(newCwnd);
+    }
+
+    void DashClient::TcpCongStateChanged(std::string context, TcpSocketState::TcpCongState_t oldState,
+        TcpSocketState::TcpCongState_t newState) {
+        // Each fast recovery or timeout follows a loss
+        if (newState != oldState
+            && (newState == TcpSocketState::CA_RECOVERY || newState == TcpSocketState::CA_LOSS)) {
+            m_transport[std::atoi(context.c_str())].AddLoss();
+        }
+    }
 
-        if(m_segmentId >= 20 && !m_fog_socket){
-            // std::cout << "Segment ID maior que 20! Conectar ao socket na fog." << std::endl;
-            ConnectToFog();
+    void DashClient::UpdateBusy(uint32_t edge) {
+        if (edge < m_pool.GetEndpoints()) {
+            m_pool.SetBusy(edge, !IsIdle(edge) || (m_probing && m_probeEdge == edge));
         }
+    }
+
+    void DashClient::EndpointConnected(uint32_t edge) {
+        NS_LOG_FUNCTION(this << edge);
+        NS_LOG_LOGIC("DashClient Connection succeeded");
+        SyncSockets();
+        m_connected = true;
+
+        // The segments of a lost connection are asked for again, whole, and
+        // the frames that were already received are dropped as they arrive
+        Ptr<Socket> socket = m_pool.GetSocket(edge);
+        for (std::deque<PendingSegment>::iterator it = m_pending.begin(); it != m_pending.end(); ++it) {
+            if (it->edge == edge && it->lost) {
+                HTTPRequestHeader requestHeader = MakeRequestHeader(it->segmentId);
+                requestHeader.SetWholeSegment(m_segmentResponses);
+                it->lost = !SendRequest(socket, it->segmentId, it->bitRate, requestHeader);
+                it->firstFrame = 0;
+                it->chunkEnd = m_timing.GetFramesPerSegment();
+            }
+        }
+        UpdateBusy(edge);
+
+        // A probe shares the parser with the segments sent again, and
+        // would take their first frames, so it waits for an idle fog
+        if (edge == FOG_EDGE && m_edgeSelection == DYNAMIC_EDGE && !m_probing && IsIdle(FOG_EDGE)) {
+            Probe(FOG_EDGE);
+        }
+
+        // The first request is sent once the server is connected
+        if (m_stallStart >= Seconds(0) || (edge == CLOUD_EDGE && m_segmentId == 0 && m_pending.empty())) {
+            RequestSegment();
+        }
+    }
+
+    void DashClient::EndpointLost(uint32_t edge) {
+        NS_LOG_FUNCTION(this << edge);
+        NS_LOG_LOGIC("DashClient, Connection to edge " << edge << " lost");
+        SyncSockets();
+        (edge == FOG_EDGE ? m_fogParser : m_parser).Reset();
+        if (m_probing && m_probeEdge == edge) {
+            m_probing = false;
+        }
+        for (std::deque<PendingSegment>::iterator it = m_pending.begin(); it != m_pending.end(); ++it) {
+            if (it->edge == edge) {
+                it->lost = true;
+            }
+        }
+    }
+
+    void DashClient::ReadReceived(uint32_t bytes, Time lastRead) {
+        // A read after an idle connection is measured from the request that woke it
+        Time interval = Simulator::Now() - Max(lastRead, m_requestTime);
+        m_reads.Add(Simulator::Now(), bytes, interval);
+        m_readTrace(bytes, interval);
+    }
+
+    void DashClient::MessageReceived(Ptr<Packet> message) {
+        NS_LOG_FUNCTION(this << message);
 
         MPEGHeader mpegHeader;
         HTTPHeader httpHeader;
+        uint32_t bytes = message->GetSize();
 
-        // Send the frame to the player
-        m_player.ReceiveFrame(&message);
-        m_segment_bytes += message.GetSize();
-        m_totBytes += message.GetSize();
+        message->RemoveHeader(mpegHeader);
+        message->RemoveHeader(httpHeader);
+
+        FrameReceived(mpegHeader, httpHeader, bytes);
+    }
 
-        message.RemoveHeader(mpegHeader);
-        message.RemoveHeader(httpHeader);
+    void DashClient::FrameReceived(const MPEGHeader &mpegHeader, const HTTPHeader &httpHeader, uint32_t bytes) {
+        NS_LOG_FUNCTION(this << bytes);
+
+        // Several connections, or a switch of endpoint with requests still
+        // pending on the previous one, deliver the frames out of order, so
+        // they wait until the ones before them have arrived
+        uint64_t key = ((uint64_t) httpHeader.GetSegmentId() << 32) | mpegHeader.GetFrameId();
+        if (key < m_nextFrame) { // Requested again after a lost connection
+            return;
+        }
+        for (std::deque<PendingSegment>::const_iterator it = m_pending.begin(); it != m_pending.end(); ++it) {
+            if (it->segmentId == httpHeader.GetSegmentId() && mpegHeader.GetFrameId() >= it->firstFrame
+                && it->bitRate != httpHeader.GetResolution()) {
+                return; // Sent before the request was abandoned
+            }
+        }
+        if (key != m_nextFrame) {
+            ReorderedFrame frame = { mpegHeader, httpHeader, bytes };
+            m_reorder.insert(std::make_pair(key, frame));
+            return;
+        }
+
+        AdvanceFrame();
+        ConsumeFrame(mpegHeader, httpHeader, bytes);
+
+        while (!m_reorder.empty() && m_reorder.begin()->first == m_nextFrame) {
+            ReorderedFrame frame = m_reorder.begin()->second;
+            m_reorder.erase(m_reorder.begin());
+
+            AdvanceFrame();
+            ConsumeFrame(frame.mpegHeader, frame.httpHeader, frame.bytes);
+        }
+    }
+
+    void DashClient::AdvanceFrame() {
+        uint32_t segment_id = m_nextFrame >> 32;
+        uint32_t frame_id = m_nextFrame & 0xffffffff;
+        m_nextFrame = frame_id + 1 == m_timing.GetFramesPerSegment() ?
+            (uint64_t) (segment_id + 1) << 32 : m_nextFrame + 1;
+    }
+
+    void DashClient::ConsumeFrame(const MPEGHeader &mpegHeader, const HTTPHeader &httpHeader, uint32_t bytes) {
+        NS_LOG_FUNCTION(this << bytes);
+
+        if (mpegHeader.GetFrameId() == 0) {
+            m_firstFrameTime = Simulator::Now();
+            m_firstFrameBytes = bytes;
+        }
+
+        m_segment_bytes += bytes;
+        m_totBytes += bytes;
+
+        // Send the frame to the player
+        m_player.ReceiveFrame(mpegHeader, httpHeader);
 
         // Calculate the buffering time
         switch (m_player.m_state) {
@@ -231,22 +722,66 @@ namespace ns3
                 NS_FATAL_ERROR("WRONG STATE");
         }
 
+        // A segment started downloading, the following ones may be requested
+        if (mpegHeader.GetFrameId() == 0 && m_pipelineDepth > 1) {
+            Prefetch();
+        }
+
+        // Halfway through a chunk, the next one is requested
+        if (!m_pending.empty() && m_pending.front().segmentId == httpHeader.GetSegmentId()
+            && m_pending.front().chunkEnd < m_timing.GetFramesPerSegment()) {
+            const PendingSegment &front = m_pending.front();
+            uint32_t length = front.chunkEnd - front.firstFrame;
+            if (mpegHeader.GetFrameId() == front.firstFrame + std::max<uint32_t>(length / 2, 1) - 1) {
+                RequestChunk();
+            }
+        }
+
+        if (m_abandon && mpegHeader.GetFrameId() + 1 < m_timing.GetFramesPerSegment()) {
+            CheckAbandonment(mpegHeader, httpHeader);
+        }
+
         // If we received the last frame of the segment
-        if (mpegHeader.GetFrameId() == MPEG_FRAMES_PER_SEGMENT - 1) {
+        if (mpegHeader.GetFrameId() == m_timing.GetFramesPerSegment() - 1) {
+            NS_ASSERT(!m_pending.empty() && m_pending.front().segmentId == httpHeader.GetSegmentId());
+
+            uint32_t segmentBytes = m_segment_bytes;
+            m_segmentFetchTime = Simulator::Now() - m_requestTime;
+            m_segmentReceivedTrace(m_pending.front().segmentId, m_pending.front().bitRate,
+                segmentBytes, m_segmentFetchTime);
+
+            // The round trip is only seen by a request that did not wait
+            // behind another one
+            const PendingSegment &received = m_pending.front();
+            if (received.requestTime == m_requestTime) {
+                m_edges.AddRtt(received.edge, Simulator::Now(), m_firstFrameTime - received.requestTime);
+            }
+            if (Simulator::Now() > m_firstFrameTime) {
+                m_edges.AddThroughput(received.edge, Simulator::Now(),
+                    8.0 * (segmentBytes - m_firstFrameBytes) / (Simulator::Now() - m_firstFrameTime).GetSeconds());
+            }
+
+            // The next pipelined segment, if any, starts downloading now
+            uint32_t edge = received.edge;
+            m_pending.pop_front();
+            UpdateBusy(edge);
+            m_requestTime = Simulator::Now();
+            m_segment_bytes = 0;
+            m_lastSegment = Simulator::Now();
 
             if(m_segmentId == m_segment_total){
-                m_player.setEndPlayer(true);
+                if (m_pending.empty()) {
+                    m_player.setEndPlayer(true);
+                }
                 return;
             }
 
-            m_segmentFetchTime = Simulator::Now() - m_requestTime;
-
             NS_LOG_INFO(
-                Simulator::Now().GetSeconds() << " bytes: " << m_segment_bytes << " segmentTime: " << m_segmentFetchTime.GetSeconds() << " segmentRate: " << 8 * m_segment_bytes / m_segmentFetchTime.GetSeconds());
+                Simulator::Now().GetSeconds() << " bytes: " << segmentBytes << " segmentTime: " << m_segmentFetchTime.GetSeconds() << " segmentRate: " << 8 * segmentBytes / m_segmentFetchTime.GetSeconds());
 
             // Feed the bitrate info to the player
             AddBitRate(Simulator::Now(),
-                8 * m_segment_bytes / m_segmentFetchTime.GetSeconds());
+                8 * segmentBytes / m_segmentFetchTime.GetSeconds());
 
             Time currDt = m_player.GetRealPlayTime(mpegHeader.GetPlaybackTime());
             // And tell the player to monitor the buffer level
@@ -269,14 +804,24 @@ namespace ns3
             }
 
             if (bufferDelay == Seconds(0)) {
-                if(m_segmentId >= 20 && m_fog_socket != *target_socket) {
-                    target_socket = &m_fog_socket;
-
-                    // std::cout << "entrou  " << m_fog_socket << "!!!" << '\n';
-                    m_socket->Close();
+                if(FogSwitchDue()) {
+                    // Once the segments requested on the other socket are received
+                    if (m_pending.empty()) {
+                        target_socket = &m_fog_socket;
+
+                        // std::cout << "entrou  " << m_fog_socket << "!!!" << '\n';
+                        m_pool.Close(CLOUD_EDGE);
+                        SyncSockets();
+                        for (std::vector<Subflow>::iterator it = m_subflows.begin(); it != m_subflows.end(); ++it) {
+                            it->socket->Close();
+                            it->connected = false;
+                        }
+
+                        RequestSegment();
+                    }
+                } else {
+                    RequestSegment();
                 }
-
-                RequestSegment();
             } else {
                 m_player.SchduleBufferWakeup(bufferDelay, this);
             }
@@ -300,52 +845,225 @@ namespace ns3
         }
     }
 
-    void DashClient::ConnectToFog() {
+    void DashClient::CheckAbandonment(const MPEGHeader &mpegHeader, const HTTPHeader &httpHeader) {
         NS_LOG_FUNCTION(this);
 
-        // Create the socket if not already
-        NS_LOG_INFO("trying to create connection with the fog node");
-        if (!m_fog_socket) {
-            NS_LOG_INFO("Just created connection");
-            m_fog_socket = Socket::CreateSocket(GetNode(), m_tid);
+        uint32_t received = mpegHeader.GetFrameId() + 1;
+        if (m_pending.empty() || m_pending.front().segmentId != httpHeader.GetSegmentId()
+            || m_pending.front().split || m_segmentResponses || received < m_abandonMinFrames
+            || m_player.m_state != MPEG_PLAYER_PLAYING || !m_pool.IsReady(m_pending.front().edge)) {
+            return;
+        }
+        PendingSegment &front = m_pending.front();
+
+        // The throughput since the first frame of the segment, which left
+        // the server once the request had arrived
+        Time elapsed = Simulator::Now() - m_firstFrameTime;
+        if (elapsed <= Seconds(0) || m_segment_bytes <= m_firstFrameBytes) {
+            return;
+        }
+        double throughput = 8.0 * (m_segment_bytes - m_firstFrameBytes) / elapsed.GetSeconds();
+
+        uint32_t frames = m_timing.GetFramesPerSegment();
+        double remainingMedia = m_timing.GetFrameInterval().GetSeconds() * (frames - received);
+        double remainingTime = front.bitRate * remainingMedia / throughput;
+        double bufferLevel = m_player.GetRealPlayTime(
+            m_timing.GetPlaybackTime(front.segmentId, received)).GetSeconds();
+        if (remainingTime <= bufferLevel) {
+            return;
+        }
+
+        // The highest lower bitrate whose frames would arrive in time
+        double fits = throughput * std::max(bufferLevel, 0.0) / remainingMedia;
+        uint32_t rate = GetLadder()->GetRateBelow(std::min(fits, front.bitRate - 1.0));
+        if (rate >= front.bitRate) {
+            return;
+        }
 
-            // Fatal error if socket type is not NS3_SOCK_STREAM or NS3_SOCK_SEQPACKET
-            if (m_fog_socket->GetSocketType() != Socket::NS3_SOCK_STREAM
-                && m_fog_socket->GetSocketType() != Socket::NS3_SOCK_SEQPACKET) {
-                NS_FATAL_ERROR("Using HTTP with an incompatible socket type. "
-                "HTTP requires SOCK_STREAM or SOCK_SEQPACKET. "
-                "In other words, use TCP instead of UDP.");
+        NS_LOG_INFO("Abandoning segment " << front.segmentId << " at frame " << received << ": "
+            << remainingTime << " s to download, " << bufferLevel << " s buffered, " << front.bitRate
+            << " -> " << rate);
+        m_requestAbandonedTrace(front.segmentId, front.bitRate, rate, received);
+
+        // The segments queued behind it on the same connection are requested
+        // again after it, so that the server sends its frames first
+        uint32_t edge = front.edge;
+        Ptr<Socket> socket = edge == FOG_EDGE ? m_fog_socket : m_socket;
+        for (std::deque<PendingSegment>::iterator it = m_pending.begin(); it != m_pending.end(); ++it) {
+            if (it->edge == edge) {
+                HTTPRequestHeader cancel;
+                cancel.SetCancel(true);
+                SendRequest(socket, it->segmentId, it->bitRate, cancel);
+            }
+        }
+        for (std::deque<PendingSegment>::iterator it = m_pending.begin(); it != m_pending.end(); ++it) {
+            if (it->edge != edge) {
+                continue;
             }
+            it->bitRate = std::min(it->bitRate, rate);
+            it->firstFrame = it == m_pending.begin() ? received : 0;
+            it->chunkEnd = frames;
+            HTTPRequestHeader requestHeader = MakeRequestHeader(it->segmentId);
+            if (it == m_pending.begin()) {
+                requestHeader.SetFrameRange(received, frames - received);
+            }
+            if (!SendRequest(socket, it->segmentId, it->bitRate, requestHeader)) {
+                NS_FATAL_ERROR("Oh oh. Couldn't send the request of segment " << it->segmentId);
+            }
+        }
 
-            if (Inet6SocketAddress::IsMatchingType(m_fog_peer)) {
-                m_fog_socket->Bind6();
-            } else if (InetSocketAddress::IsMatchingType(m_fog_peer)) {
-                m_fog_socket->Bind();
+        if (rate < m_bitRate) {
+            m_bitRate = rate;
+            m_rateChanges++;
+        }
+    }
+
+    void DashClient::RequestChunk() {
+        NS_LOG_FUNCTION(this);
+
+        PendingSegment &front = m_pending.front();
+        if (!m_pool.IsReady(front.edge)) { // The whole segment is requested again on reconnection
+            return;
+        }
+
+        uint32_t frames = m_timing.GetFramesPerSegment();
+        uint32_t first = front.chunkEnd;
+        uint32_t count = std::min(m_chunkFrames, frames - first);
+
+        // A chunk may take longer to download than it plays, as long as the
+        // buffer covers the difference
+        uint32_t rate = front.targetRate;
+        Time elapsed = Simulator::Now() - m_firstFrameTime;
+        if (elapsed > Seconds(0) && m_segment_bytes > m_firstFrameBytes) {
+            double throughput = 8.0 * (m_segment_bytes - m_firstFrameBytes) / elapsed.GetSeconds();
+            double chunkMedia = m_timing.GetFrameInterval().GetSeconds() * count;
+            double bufferLevel = chunkMedia;
+            if (m_player.m_state == MPEG_PLAYER_PLAYING) {
+                bufferLevel = std::max(chunkMedia, m_player.GetRealPlayTime(
+                    m_timing.GetPlaybackTime(front.segmentId, first)).GetSeconds());
             }
+            rate = GetLadder()->GetRateBelow(std::min<double>(front.targetRate,
+                throughput * bufferLevel / chunkMedia));
+        }
 
-            m_fog_socket->Connect(m_fog_peer);
-            m_fog_socket->SetRecvCallback(MakeCallback(&DashClient::HandleRead, this));
-            m_fog_socket->SetConnectCallback(
-                MakeCallback(&DashClient::ConnectionFogSucceeded, this),
-                MakeCallback(&DashClient::ConnectionFogFailed, this));
-            m_fog_socket->SetSendCallback(MakeCallback(&DashClient::DataSend, this));
+        HTTPRequestHeader requestHeader = MakeRequestHeader(front.segmentId);
+        requestHeader.SetFrameRange(first, count);
+        Ptr<Socket> socket = front.edge == FOG_EDGE ? m_fog_socket : m_socket;
+        if (!SendRequest(socket, front.segmentId, rate, requestHeader)) {
+            NS_FATAL_ERROR("Oh oh. Couldn't send the request of segment " << front.segmentId);
         }
+        NS_LOG_INFO("Segment " << front.segmentId << " frames " << first << "+" << count << " at " << rate);
 
-        NS_LOG_INFO("Just started connection");
+        front.bitRate = rate;
+        front.firstFrame = first;
+        front.chunkEnd = first + count;
+
+        // The following segments may be requested once the last chunk is
+        if (front.chunkEnd == frames && m_pipelineDepth > 1) {
+            Prefetch();
+        }
     }
 
-    void DashClient::ConnectionFogSucceeded(Ptr<Socket> socket) {
-        NS_LOG_FUNCTION(this << socket);
-        NS_LOG_LOGIC("DashClient Fog Connection succeeded");
-        m_connected = true;
-        // RequestSegment();
+    bool DashClient::ChunksPending() const {
+        return !m_pending.empty() && m_pending.back().chunkEnd < m_timing.GetFramesPerSegment();
     }
 
-    void DashClient::ConnectionFogFailed(Ptr<Socket> socket) {
-        NS_LOG_FUNCTION(this << socket);NS_LOG_LOGIC(
-            "DashClient, Fog Connection Failed");
+    bool DashClient::FogSwitchDue() const {
+        return m_edgeSelection == FIXED_SEGMENT_EDGE && m_segmentId >= 20 && m_pool.GetEndpoints() > FOG_EDGE
+            && GetEdge() != FOG_EDGE;
+    }
 
-        // std::cout << "DashClient, Fog Connection Failed" << '\n';
+    uint32_t DashClient::GetEdge() const {
+        return target_socket == &m_fog_socket ? FOG_EDGE : CLOUD_EDGE;
+    }
+
+    bool DashClient::IsIdle(uint32_t edge) const {
+        for (std::deque<PendingSegment>::const_iterator it = m_pending.begin(); it != m_pending.end(); ++it) {
+            if (it->edge == edge) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void DashClient::SelectEdge() {
+        NS_LOG_FUNCTION(this);
+
+        uint32_t current = GetEdge();
+        uint32_t other = current == FOG_EDGE ? CLOUD_EDGE : FOG_EDGE;
+        if (m_pool.GetEndpoints() <= FOG_EDGE) {
+            return;
+        }
+
+        // The statistics of the other endpoint are refreshed when they are
+        // old, while it has no segment to send, connecting it first if it
+        // was closed for being idle
+        if (IsIdle(other) && m_edges.GetLastUpdate(other) < Simulator::Now() - m_probeInterval) {
+            if (!m_pool.IsReady(other)) {
+                m_pool.Open(other);
+                SyncSockets();
+            } else if (!m_probing) {
+                Probe(other);
+            }
+        }
+        if (!m_edges.HasData(current) || !m_edges.HasData(other)) {
+            return;
+        }
+
+        double bits = (double) m_bitRate * m_timing.GetSegmentDuration().GetSeconds();
+        uint32_t next = m_edges.Select(current, other, bits);
+        m_edgeSelectedTrace(m_segmentId, current, next, m_edges.PredictFetchTime(current, bits),
+            m_edges.PredictFetchTime(other, bits));
+
+        if (next != current && m_pool.IsReady(next)) {
+            NS_LOG_INFO("Segment " << m_segmentId << " moves to edge " << next);
+            target_socket = next == FOG_EDGE ? &m_fog_socket : &m_socket;
+        }
+    }
+
+    void DashClient::Probe(uint32_t edge) {
+        NS_LOG_FUNCTION(this << edge);
+
+        HTTPRequestHeader requestHeader;
+        requestHeader.SetFrameRange(0, m_probeFrames);
+
+        Ptr<Socket> socket = edge == FOG_EDGE ? m_fog_socket : m_socket;
+        if (!SendRequest(socket, m_segmentId, GetLadder()->GetLowest(), requestHeader)) {
+            NS_LOG_WARN("Could not send the probe of edge " << edge);
+            return;
+        }
+
+        (edge == FOG_EDGE ? m_fogParser : m_parser).SetProbe(true);
+        m_probing = true;
+        m_probeEdge = edge;
+        m_probeSent = Simulator::Now();
+        m_probeExpected = std::min(m_probeFrames, m_timing.GetFramesPerSegment());
+        m_probeReceived = 0;
+        m_probeBytes = 0;
+        UpdateBusy(edge);
+    }
+
+    void DashClient::ProbeReceived(Ptr<Packet> message) {
+        NS_LOG_FUNCTION(this << message);
+        NS_ASSERT(m_probing);
+
+        // The first frame gives the round trip, the following ones the throughput
+        if (m_probeReceived++ == 0) {
+            m_probeFirst = Simulator::Now();
+            m_edges.AddRtt(m_probeEdge, Simulator::Now(), Simulator::Now() - m_probeSent);
+        } else {
+            m_probeBytes += message->GetSize();
+        }
+
+        if (m_probeReceived == m_probeExpected) {
+            (m_probeEdge == FOG_EDGE ? m_fogParser : m_parser).SetProbe(false);
+            m_probing = false;
+            UpdateBusy(m_probeEdge);
+            if (Simulator::Now() > m_probeFirst) {
+                m_edges.AddThroughput(m_probeEdge, Simulator::Now(),
+                    8.0 * m_probeBytes / (Simulator::Now() - m_probeFirst).GetSeconds());
+            }
+        }
     }
 
     void DashClient::CalcNextSegment(uint32_t currRate, uint32_t & nextRate, Time & delay) {
@@ -354,6 +1072,7 @@ namespace ns3
     }
 
     std::string DashClient::GetStats() {
+        m_player.Advance();
         std::cout << " InterruptionTime: "
             << m_player.m_interruption_time.GetSeconds() << " interruptions: "
             << m_player.m_interrruptions << " avgRate: "
@@ -372,43 +1091,42 @@ namespace ns3
         return data.str();
     }
 
-    void DashClient::LogBufferLevel(Time t) {
-        m_bufferState[Simulator::Now()] = t;
-        for (std::map<Time, Time>::iterator it = m_bufferState.begin(); it != m_bufferState.end(); ++it) {
-            if (it->first < (Simulator::Now() - m_window)) {
-                m_bufferState.erase(it->first);
-            }
+    double DashClient::GetGoodput() const {
+        if (m_firstRequest < Seconds(0) || m_lastSegment <= m_firstRequest) {
+            return 0;
         }
+        // The bytes of the segment being received are not counted yet
+        return 8.0 * (m_totBytes - m_segment_bytes) / (m_lastSegment - m_firstRequest).GetSeconds();
     }
 
-    double DashClient::GetBufferEstimate() {
-        double sum = 0;
-        int count = 0;
-        for (std::map<Time, Time>::iterator it = m_bufferState.begin();
-        it != m_bufferState.end(); ++it) {
-            sum += it->second.GetSeconds();
-            count++;
-        }
-        return sum / count;
+    Time DashClient::GetHandshakeStallTime() const {
+        return m_handshakeStall;
     }
 
-    double DashClient::GetBufferDifferential() {
-        std::map<Time, Time>::iterator it = m_bufferState.end();
+    const TransportStats& DashClient::GetTransportStats(uint32_t edge) const {
+        NS_ASSERT(edge <= FOG_EDGE);
+        return m_transport[edge];
+    }
 
-        if (it == m_bufferState.begin()) {
-            // Empty buffer
-            return 0;
-        }
-        it--;
-        Time last = it->second;
+    double DashClient::GetTransportEstimate() const {
+        return m_transport[GetEdge()].GetBandwidthEstimate();
+    }
+
+    void DashClient::LogBufferLevel(Time t) {
+        m_bufferState.Add(Simulator::Now(), t.GetSeconds());
+        m_bufferState.Expire(Simulator::Now() - m_window);
+    }
+
+    double DashClient::GetBufferEstimate() {
+        return m_bufferState.GetMean();
+    }
 
-        if (it == m_bufferState.begin()) {
-            // Only one element
+    double DashClient::GetBufferDifferential() {
+        if (m_bufferState.GetCount() < 2) {
+            // Empty buffer, or only one element
             return 0;
         }
-        it--;
-        Time prev = it->second;
-        return (last - prev).GetSeconds();
+        return m_bufferState.GetValue(0) - m_bufferState.GetValue(1);
     }
 
     double DashClient::GetSegmentFetchTime() {
@@ -416,18 +1134,39 @@ namespace ns3
     }
 
     void DashClient::AddBitRate(Time time, double bitrate) {
-        m_bitrates[time] = bitrate;
-        double sum = 0;
-        int count = 0;
-        for (std::map<Time, double>::iterator it = m_bitrates.begin(); it != m_bitrates.end(); ++it) {
-            if (it->first < (Simulator::Now() - m_window)) {
-                m_bitrates.erase(it->first);
-            } else {
-                sum += it->second;
-                count++;
+        m_bitrates.Add(time, bitrate);
+        m_bitrates.Expire(Simulator::Now() - m_window);
+        Ptr<ThroughputEstimator> estimator = GetThroughputEstimator();
+        estimator->AddSample(time, bitrate);
+        m_bitrateEstimate = estimator->GetEstimate();
+    }
+
+    Ptr<ThroughputEstimator> DashClient::GetThroughputEstimator() {
+        if (!m_estimator) {
+            ObjectFactory factory;
+            factory.SetTypeId(m_estimatorTid);
+            TypeId::AttributeInformation info;
+            if (m_estimatorTid.LookupAttributeByName("Window", &info)) {
+                factory.Set("Window", TimeValue(m_window));
             }
+            m_estimator = factory.Create<ThroughputEstimator>();
         }
-        m_bitrateEstimate = sum / count;
+        return m_estimator;
+    }
+
+    Ptr<const BitrateLadder> DashClient::GetLadder() {
+        if (!m_ladder) {
+            m_ladder = BitrateLadder::Get(m_videoId);
+        }
+        return m_ladder;
+    }
+
+    double DashClient::GetBitRateHarmonicMean() {
+        return m_bitrates.GetHarmonicMean();
+    }
+
+    double DashClient::GetBitRateMin() {
+        return m_bitrates.GetMin();
     }
 
 } // Namespace ns3
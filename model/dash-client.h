@@ -24,12 +24,25 @@
 #include "ns3/application.h"
 #include "ns3/ptr.h"
 #include "ns3/socket.h"
+#include "ns3/tcp-socket-base.h"
 #include "mpeg-player.h"
 #include "ns3/traced-callback.h"
 #include "http-parser.h"
+#include "http-request-header.h"
+#include "sliding-window.h"
+#include "throughput-estimator.h"
+#include "bitrate-ladder.h"
+#include "video-timing.h"
+#include "edge-selector.h"
+#include "connection-pool.h"
+#include "read-sample-ring.h"
+#include "transport-stats.h"
 
 #include <cstdio>
+#include <deque>
+#include <map>
 #include <string>
+#include <vector>
 
 namespace ns3
 {
@@ -72,6 +85,78 @@ namespace ns3
 
         virtual ~DashClient();
 
+        /**
+         * TracedCallback signature for the segments that have been received.
+         *
+         * \param [in] segment_id The id of the segment.
+         * \param [in] bitrate The bitrate it was requested at.
+         * \param [in] bytes The bytes it took, headers included.
+         * \param [in] fetchTime The time from when it started downloading,
+         * which for a pipelined segment is when the previous one ended.
+         */
+        typedef void (* SegmentReceivedTracedCallback)(uint32_t segment_id, uint32_t bitrate,
+            uint32_t bytes, Time fetchTime);
+
+        /**
+         * TracedCallback signature for the choices of endpoint.
+         *
+         * \param [in] segment_id The id of the segment about to be requested.
+         * \param [in] from The endpoint of the previous segment.
+         * \param [in] to The endpoint chosen, the same one if the client stays.
+         * \param [in] fromFetchTime The fetch time predicted on the previous endpoint.
+         * \param [in] otherFetchTime The fetch time predicted on the other endpoint.
+         */
+        typedef void (* EdgeSelectedTracedCallback)(uint32_t segment_id, uint32_t from, uint32_t to,
+            Time fromFetchTime, Time otherFetchTime);
+
+        /**
+         * TracedCallback signature for the abandoned segment requests.
+         *
+         * \param [in] segment_id The id of the segment.
+         * \param [in] from The bitrate it was being received at.
+         * \param [in] to The bitrate its remaining frames are requested at.
+         * \param [in] frame_id The first frame requested again.
+         */
+        typedef void (* RequestAbandonedTracedCallback)(uint32_t segment_id, uint32_t from, uint32_t to,
+            uint32_t frame_id);
+
+        /**
+         * TracedCallback signature for the reads of the client sockets.
+         *
+         * \param [in] bytes The bytes read.
+         * \param [in] interval The time since the previous read of the
+         * connection, or since the request of the segment being received
+         * if that is later.
+         */
+        typedef void (* ReadSampleTracedCallback)(uint32_t bytes, Time interval);
+
+        /**
+         * TracedCallback signature for the throughput estimates started over
+         * on a switch of endpoint, see TransportColdStart.
+         *
+         * \param [in] edge The endpoint the requests moved to.
+         * \param [in] bitrate The estimate of its connection, in bps.
+         */
+        typedef void (* EstimateSeededTracedCallback)(uint32_t edge, double bitrate);
+
+        /**
+         * How the client chooses between the server and the fog node.
+         */
+        enum EdgeSelectionType
+        {
+            DYNAMIC_EDGE,       // The shortest predicted fetch time, by a margin
+            FIXED_SEGMENT_EDGE  // The fog node from segment 20 on
+        };
+
+        /**
+         * The endpoints, as reported by EdgeSelected.
+         */
+        enum
+        {
+            CLOUD_EDGE = 0,     // Remote
+            FOG_EDGE = 1        // FogRemote
+        };
+
         /**
          * \return pointer to associated socket
          */
@@ -82,6 +167,31 @@ namespace ns3
          */
         std::string GetStats();
 
+        /**
+         * \return the bits per second received, from the first request to
+         * the last received segment.
+         */
+        double GetGoodput() const;
+
+        /**
+         * \return the time the requests waited for the handshake of their
+         * endpoint, as it was closed, lost or still connecting.
+         */
+        Time GetHandshakeStallTime() const;
+
+        /**
+         * \return the TCP state of the connection to the endpoint, as seen
+         * by the traces of its socket since it was opened.
+         */
+        const TransportStats& GetTransportStats(uint32_t edge) const;
+
+        /**
+         * \return the connections of the client to its endpoints.
+         */
+        inline const ConnectionPool& GetConnectionPool() const {
+            return m_pool;
+        }
+
         /**
          * \return The MpegPlayer object that is used for buffering and
          * reproducing the video, and for estimating the next bitrate (resolution)
@@ -91,6 +201,14 @@ namespace ns3
             return m_player;
         }
 
+        /**
+         * \return The HttpParser object that splits the received stream into
+         * MPEG frames.
+         */
+        inline const HttpParser& GetParser() const {
+            return m_parser;
+        }
+
     protected:
         virtual void DoDispose(void);
 
@@ -104,12 +222,50 @@ namespace ns3
 
         double GetBufferEstimate();
 
+        double GetBitRateHarmonicMean();
+
+        double GetBitRateMin();
+
+        /**
+         * \return the estimator that sets m_bitrateEstimate, made on first
+         * use from the ThroughputEstimator attribute.
+         */
+        Ptr<ThroughputEstimator> GetThroughputEstimator();
+
+        /**
+         * \return the bitrates of the video, see BitrateLadder::Get.
+         */
+        Ptr<const BitrateLadder> GetLadder();
+
+        /**
+         * \return the frame rate and segment length of the video, see
+         * VideoTiming::Get.
+         */
+        inline const VideoTiming& GetTiming() const {
+            return m_timing;
+        }
+
         double GetSegmentFetchTime();
 
-        std::map<Time, Time> m_bufferState;
+        /**
+         * \return the last socket reads, for the algorithms that react
+         * within a segment. Their number is set by ReadSamples.
+         */
+        inline const ReadSampleRing& GetReadSamples() const {
+            return m_reads;
+        }
+
+        /**
+         * \return the bits per second the connection the requests are sent
+         * to would carry, as its congestion window per smoothed round trip,
+         * or 0 until both are known.
+         */
+        double GetTransportEstimate() const;
+
+        SlidingWindow m_bufferState; // The buffering times (s), over the last window
         uint32_t m_rateChanges;
         Time m_target_dt;
-        std::map<Time, double> m_bitrates;
+        SlidingWindow m_bitrates;    // The segment bitrates (bps), over the last window
         double m_bitrateEstimate;
         uint32_t m_segmentId;    // The id of the current segment
 
@@ -127,36 +283,116 @@ namespace ns3
          *
          * \param the message that was received
          */
-        void MessageReceived(Packet message);
+        void MessageReceived(Ptr<Packet> message);
+
+        /**
+         * \brief Called by the HttpParser for each read of its socket.
+         *
+         * \param lastRead the time of the previous read of the socket,
+         * zero if there was none.
+         */
+        void ReadReceived(uint32_t bytes, Time lastRead);
+
+        /**
+         * \brief Called by the HttpParser of an endpoint for the frames that
+         * answer a probe, which are not played.
+         */
+        void ProbeReceived(Ptr<Packet> message);
+
+        /**
+         * \brief Requests the segments after the ones being downloaded, up
+         * to the pipeline depth, as long as the adaptation algorithm does
+         * not ask to wait.
+         */
+        void Prefetch();
+
+        /**
+         * \brief Called for each MPEG frame that has been received, whether
+         * as a message of its own or as part of a whole segment response.
+         * With several connections the frames are put back in order first.
+         *
+         * \param bytes the bytes the frame took, headers included
+         */
+        void FrameReceived(const MPEGHeader &mpegHeader, const HTTPHeader &httpHeader, uint32_t bytes);
+
+        /**
+         * \brief Plays the frames in order, and requests the next segment
+         * once the last frame of the current one is received.
+         */
+        void ConsumeFrame(const MPEGHeader &mpegHeader, const HTTPHeader &httpHeader, uint32_t bytes);
+        void AdvanceFrame();    // Moves m_nextFrame past the frame it points to
+
+        /**
+         * \brief Called for each frame of the segment being received. If its
+         * remaining frames are predicted to arrive after the player needs
+         * them, at the throughput seen since its first frame, the request
+         * is cancelled and the remaining frames are requested again at the
+         * highest lower bitrate that would arrive in time.
+         */
+        void CheckAbandonment(const MPEGHeader &mpegHeader, const HTTPHeader &httpHeader);
+
+        /**
+         * \brief Requests the next chunk of the segment being received, at
+         * the highest bitrate up to the one decided for the segment that
+         * the throughput seen since its first frame sustains, see ChunkFrames.
+         */
+        void RequestChunk();
+
+        bool FogSwitchDue() const;  // True when the FixedSegment rule moves to the fog node
+        bool ChunksPending() const; // True while the last requested segment has chunks to request
+        uint32_t GetEdge() const;   // The endpoint the requests are sent to
+        bool IsIdle(uint32_t edge) const;  // True if no requested segment is expected from it
+        void SelectEdge();          // Picks the endpoint of the next request, probing the other one if needed
+        void Probe(uint32_t edge);  // Asks the endpoint for a few frames, to measure it
+
+        /**
+         * \return a request for the segment, with the buffer level and
+         * deadline of the player when it has started.
+         */
+        HTTPRequestHeader MakeRequestHeader(uint32_t segment_id);
+
+        /**
+         * \return false if the socket did not take the whole request.
+         */
+        bool SendRequest(Ptr<Socket> socket, uint32_t segment_id, uint32_t bitRate,
+            const HTTPRequestHeader &requestHeader);
 
         // inherited from Application base class.
         virtual void StartApplication(void);    // Called at time specified by Start
         virtual void StopApplication(void);     // Called at time specified by Stop
-        void ConnectionSucceeded(Ptr<Socket> socket); // Called when the connections has succeeded
-        void ConnectionFailed(Ptr<Socket> socket); // Called when the connection has failed.
-        void DataSend(Ptr<Socket>, uint32_t); // Called when the data has been transmitted
+        void EndpointConnected(uint32_t edge); // Called by the pool when a connection is up
+        void EndpointLost(uint32_t edge);      // Called by the pool when a connection failed or was closed
+        void SyncSockets();                    // Takes the sockets of the endpoints from the pool
+        void UpdateBusy(uint32_t edge);        // Tells the pool whether the endpoint has requests
+        void Monitor(uint32_t edge);           // Follows the TCP traces of the socket of the endpoint
+        void Unmonitor(uint32_t edge);
+        void ConnectionFailed(Ptr<Socket> socket); // Called when one of the other connections has failed
+        void SubflowSucceeded(Ptr<Socket> socket); // Called when one of the other connections has succeeded
         void HandleRead(Ptr<Socket>); // Called when we receive data from the server
+
+        // The TCP trace sinks, with the endpoint as the context
+        void TcpRttChanged(std::string context, Time oldRtt, Time newRtt);
+        void TcpCwndChanged(std::string context, uint32_t oldCwnd, uint32_t newCwnd);
+        void TcpCongStateChanged(std::string context, TcpSocketState::TcpCongState_t oldState,
+            TcpSocketState::TcpCongState_t newState);
         virtual void CalcNextSegment(uint32_t currRate, uint32_t & nextRate, Time & delay);
         void LogBufferLevel(Time t);
         void inline SetWindow(Time time) {
             m_window = time;
         }
 
-        void ConnectToFog();
-        void ConnectionFogSucceeded(Ptr<Socket> socket);
-        void ConnectionFogFailed(Ptr<Socket> socket);
-
         Ptr<Socket> *target_socket;
 
         MpegPlayer m_player;     // The MpegPlayer object
         HttpParser m_parser;     // An HttpParser object for parsing the incoming stream into http messages
         Ptr<Socket> m_socket;    // Associated socket
         Address m_peer;          // Peer address
-        bool m_connected;        // True if connected
+        bool m_connected;        // True once an endpoint has connected
         uint32_t m_totBytes;     // Total bytes received.
 
         Ptr<Socket> m_fog_socket;    // Fog Associated socket
         Address m_fog_peer;          // Fog Peer address
+        HttpParser m_fogParser;      // For the fog socket
 
         TypeId m_tid;
         TracedCallback<Ptr<const Packet> > m_txTrace;
@@ -166,13 +402,93 @@ namespace ns3
         Time m_lastDt; // The previous buffering time (used for calculating the differential
         static int m_countObjs; // Number of DashClient instances (for generating unique id
         int m_id;
-        Time m_requestTime;      // Time of sending the last request
+        Time m_requestTime;      // Time the segment being received started downloading
         uint32_t m_segment_bytes; // Bytes of the current segment that have been received so far
         uint32_t m_bitRate;      // The bitrate of the current segment.
         Time m_window;
         Time m_segmentFetchTime;
 
         uint32_t m_segment_total;
+        bool m_analyticPlayback; // Plays the frames lazily, without an event per frame
+        bool m_segmentResponses; // Asks for one response per segment instead of one per frame
+        TypeId m_estimatorTid;   // The type of m_estimator
+        Ptr<ThroughputEstimator> m_estimator;
+        Ptr<const BitrateLadder> m_ladder; // Shared with the other clients of the video
+        VideoTiming m_timing;    // Of the video, from when the client started
+
+        // A segment that has been requested and is not fully received
+        struct PendingSegment {
+            uint32_t segmentId;
+            uint32_t bitRate;
+            Time requestTime;
+            uint32_t edge;      // The endpoint it was requested from
+            bool lost;          // Its connection was lost, it is requested again on reconnection
+            bool split;         // Requested over several connections
+            uint32_t firstFrame; // The frames from this one on are expected at bitRate
+            uint32_t chunkEnd;  // The frames before this one have been requested
+            uint32_t targetRate; // Decided for the segment, the most its chunks are requested at
+        };
+        std::deque<PendingSegment> m_pending; // In the order they will arrive
+        uint32_t m_pipelineDepth; // The most requests that may be outstanding
+        Time m_firstRequest;     // For the goodput
+        Time m_lastSegment;      // The time the last segment was fully received
+
+        // One of the other connections to the server, see Connections
+        struct Subflow {
+            Ptr<Socket> socket;
+            HttpParser parser;
+            bool connected;
+        };
+        // A frame that arrived before the ones it follows
+        struct ReorderedFrame {
+            MPEGHeader mpegHeader;
+            HTTPHeader httpHeader;
+            uint32_t bytes;
+        };
+        uint32_t m_connections;  // Including m_socket
+        std::vector<Subflow> m_subflows;
+        std::map<uint64_t, ReorderedFrame> m_reorder; // Keyed by segment id << 32 | frame id
+        uint64_t m_nextFrame;    // The key of the next frame to play
+
+        EdgeSelector m_edges;    // The statistics of the endpoints
+        EdgeSelectionType m_edgeSelection;
+        double m_edgeMargin;
+        uint32_t m_probeFrames;
+        Time m_probeInterval;
+        bool m_probing;          // A probe is being answered
+        uint32_t m_probeEdge;    // By this endpoint
+        Time m_probeSent;
+        Time m_probeFirst;       // The arrival of its first frame
+        uint32_t m_probeExpected; // Frames
+        uint32_t m_probeReceived;
+        uint32_t m_probeBytes;   // Received after the first frame
+        Time m_firstFrameTime;   // The arrival of the first frame of the segment being received
+        uint32_t m_firstFrameBytes;
+        TracedCallback<uint32_t, uint32_t, uint32_t, Time, Time> m_edgeSelectedTrace;
+        TracedCallback<uint32_t, uint32_t, uint32_t, Time> m_segmentReceivedTrace;
+
+        ConnectionPool m_pool;   // The connections to Remote and FogRemote, by edge
+        Time m_idleTimeout;
+        Time m_reconnectBackoff;
+        Time m_maxReconnectBackoff;
+        Time m_stallStart;       // When a request started waiting for a handshake, negative if none
+        Time m_handshakeStall;   // The total of those waits
+        TracedCallback<Time> m_handshakeStallTrace;
+
+        bool m_abandon;          // Abandons the segments that would stall the player
+        uint32_t m_abandonMinFrames; // Received before the throughput is trusted
+        uint32_t m_chunkFrames;  // Of each request, 0 for whole segments
+
+        ReadSampleRing m_reads;  // The last socket reads
+        uint32_t m_readSamples;  // Kept in m_reads
+        TracedCallback<uint32_t, Time> m_readTrace;
+        TracedCallback<uint32_t, uint32_t, uint32_t, uint32_t> m_requestAbandonedTrace;
+
+        TransportStats m_transport[FOG_EDGE + 1]; // By edge
+        Ptr<Socket> m_monitored[FOG_EDGE + 1];    // The sockets they are fed by
+        bool m_transportColdStart; // Starts the estimate over from them on a switch of endpoint
+        uint32_t m_requestEdge;  // The endpoint of the last request
+        TracedCallback<uint32_t, double> m_estimateSeededTrace;
 
         Ipv4Address ipAddress; 
     };
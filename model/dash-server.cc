@@ -34,12 +34,20 @@
 #include "ns3/udp-socket-factory.h"
 #include "dash-server.h"
 #include "http-header.h"
+#include "http-request-header.h"
 #include "mpeg-header.h"
-#include <ns3/random-variable-stream.h>
+#include "segment-cache.h"
+#include "segment-cursor.h"
 #include <ns3/tcp-socket-factory.h>
 #include <ns3/tcp-socket.h>
+#include <ns3/pointer.h>
+#include <ns3/uinteger.h>
+#include <ns3/enum.h>
 #include <ns3/double.h>
 
+#include <algorithm>
+#include <limits>
+
 namespace ns3
 {
     NS_LOG_COMPONENT_DEFINE("DashServer");
@@ -53,9 +61,39 @@ namespace ns3
             MakeAddressAccessor(&DashServer::m_local), MakeAddressChecker()).AddAttribute(
             "Protocol", "The type id of the protocol to use for the rx socket.",
             TypeIdValue(TcpSocketFactory::GetTypeId()),
-            MakeTypeIdAccessor(&DashServer::m_tid), MakeTypeIdChecker()).AddTraceSource(
+            MakeTypeIdAccessor(&DashServer::m_tid), MakeTypeIdChecker())
+            .AddAttribute("SegmentCache",
+            "The cache of the synthesized segments. A private cache is created when it is not set, "
+            "so servers that set the same cache share their segments.",
+            PointerValue(), MakePointerAccessor(&DashServer::m_cache),
+            MakePointerChecker<SegmentCache>())
+            .AddAttribute("Quantum",
+            "The bytes a connection may send each time its turn comes, when several connections "
+            "have frames to send (deficit round robin).",
+            UintegerValue(3000), MakeUintegerAccessor(&DashServer::m_quantum),
+            MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("Scheduler",
+            "The order in which the connections send their frames, when several of them can send. "
+            "Fifo serves them in the order they became ready, Drr in deficit round robin, and Edf "
+            "starts with the segment that the clients will play first.",
+            EnumValue(DashServer::DRR), MakeEnumAccessor(&DashServer::m_scheduler),
+            MakeEnumChecker(DashServer::FIFO, "Fifo", DashServer::DRR, "Drr",
+            DashServer::EDF, "Edf"))
+            .AddAttribute("PacingFactor",
+            "Paces each connection with a token bucket, at this multiple of the resolution of the "
+            "segment it is sending. Zero disables pacing, and the sockets are filled as fast as they "
+            "accept frames.",
+            DoubleValue(0), MakeDoubleAccessor(&DashServer::m_pacingFactor),
+            MakeDoubleChecker<double>(0))
+            .AddAttribute("BucketDepth",
+            "The size in bytes of the token bucket of a paced connection, i.e. its largest burst.",
+            UintegerValue(15000), MakeUintegerAccessor(&DashServer::m_bucketDepth),
+            MakeUintegerChecker<uint32_t>(1)).AddTraceSource(
             "Rx", "A packet has been received",
-            MakeTraceSourceAccessor(&DashServer::m_rxTrace), "ns3::Packet::TracedCallback");
+            MakeTraceSourceAccessor(&DashServer::m_rxTrace), "ns3::Packet::TracedCallback")
+            .AddTraceSource("ConnectionTx", "The bytes served so far to a connection, after each frame",
+            MakeTraceSourceAccessor(&DashServer::m_connectionTxTrace),
+            "ns3::DashServer::ConnectionTxTracedCallback");
         return tid;
     }
 
@@ -63,6 +101,11 @@ namespace ns3
         NS_LOG_FUNCTION(this);
         m_socket = 0;
         m_totalRx = 0;
+        m_quantum = 3000;
+        m_scheduler = DRR;
+        m_scheduling = false;
+        m_pacingFactor = 0;
+        m_bucketDepth = 15000;
     }
 
     DashServer::~DashServer() {
@@ -83,6 +126,11 @@ namespace ns3
         NS_LOG_FUNCTION(this);
         m_socket = 0;
         m_socketList.clear();
+        m_connections.clear();
+        m_active.clear();
+        m_deadlines.clear();
+        m_scheduleEvent.Cancel();
+        m_cache = 0;
 
         // chain up
         Application::DoDispose();
@@ -91,6 +139,10 @@ namespace ns3
     // Application Methods
     void DashServer::StartApplication() {    // Called at time specified by Start
         NS_LOG_FUNCTION(this);
+        if (!m_cache) {
+            m_cache = CreateObject<SegmentCache>();
+        }
+
         // Create the socket if not already
         if (!m_socket) {
             m_socket = Socket::CreateSocket(GetNode(), m_tid);
@@ -123,6 +175,10 @@ namespace ns3
 
     void DashServer::StopApplication() {    // Called at time specified by Stop
         NS_LOG_FUNCTION(this);
+        m_scheduleEvent.Cancel();
+        for (ConnectionMap::iterator it = m_connections.begin(); it != m_connections.end(); ++it) {
+            it->second.pacingEvent.Cancel();
+        }
         while (!m_socketList.empty()) {  //these are accepted sockets, close them
             Ptr<Socket> acceptedSocket = m_socketList.front();
             m_socketList.pop_front();
@@ -143,12 +199,6 @@ namespace ns3
             }
             m_totalRx += packet->GetSize();
 
-            HTTPHeader header;
-            packet->RemoveHeader(header);
-
-            SendSegment(header.GetVideoId(), header.GetResolution(),
-            header.GetSegmentId(), socket);
-
             if (InetSocketAddress::IsMatchingType(from)) {
                 NS_LOG_INFO(
                     "At time " << Simulator::Now ().GetSeconds () << "s packet sink received " << packet->GetSize () << " bytes from " << InetSocketAddress::ConvertFrom(from).GetIpv4 () << " port " << InetSocketAddress::ConvertFrom (from).GetPort () << " total Rx " << m_totalRx << " bytes");
@@ -157,15 +207,59 @@ namespace ns3
                     "At time " << Simulator::Now ().GetSeconds () << "s packet sink received " << packet->GetSize () << " bytes from " << Inet6SocketAddress::ConvertFrom(from).GetIpv6 () << " port " << Inet6SocketAddress::ConvertFrom (from).GetPort () << " total Rx " << m_totalRx << " bytes");
             }
             m_rxTrace(packet, from);
+
+            // A read may hold part of a request, or several pipelined ones
+            Connection &conn = GetConnection(socket);
+            conn.parser.Push(packet);
+
+            HTTPHeader header;
+            HTTPRequestHeader requestHeader;
+            while (conn.parser.Next(header, requestHeader)) {
+                if (requestHeader.IsCancel()) {
+                    CancelSegment(conn, header.GetVideoId(), header.GetSegmentId());
+                    continue;
+                }
+                SendSegment(header.GetVideoId(), header.GetResolution(),
+                header.GetSegmentId(), requestHeader, socket);
+            }
         }
     }
 
     void DashServer::HandlePeerClose(Ptr<Socket> socket) {
         NS_LOG_FUNCTION(this << socket);
+        RemoveConnection(socket);
     }
 
     void DashServer::HandlePeerError(Ptr<Socket> socket) {
         NS_LOG_FUNCTION(this << socket);
+        RemoveConnection(socket);
+    }
+
+    DashServer::Connection& DashServer::GetConnection(Ptr<Socket> socket) {
+        Connection &conn = m_connections[PeekPointer(socket)];
+        if (!conn.socket) {
+            conn.socket = socket;
+            conn.deficit = 0;
+            conn.active = false;
+            conn.txBytes = 0;
+            conn.tokens = m_bucketDepth;
+            conn.lastRefill = Simulator::Now();
+        }
+        return conn;
+    }
+
+    void DashServer::RemoveConnection(Ptr<Socket> socket) {
+        ConnectionMap::iterator it = m_connections.find(PeekPointer(socket));
+        if (it == m_connections.end()) {
+            return;
+        }
+        it->second.pacingEvent.Cancel();
+        if (it->second.active && m_scheduler == EDF) {
+            m_deadlines.erase(it->second.edf);
+        } else if (it->second.active) {
+            m_active.erase(std::find(m_active.begin(), m_active.end(), &it->second));
+        }
+        m_connections.erase(it);
     }
 
     void DashServer::HandleAccept(Ptr<Socket> s, const Address& from) {
@@ -178,6 +272,8 @@ namespace ns3
 
         m_socketList.push_back(s);
 
+        GetConnection(s);
+
         // this->nodeMap[s] = NodeType::User;
 
         // Ptr<Socket> fog = ConnectFog();
@@ -247,79 +343,246 @@ namespace ns3
 
     void  DashServer::DataSend(Ptr<Socket> socket, uint32_t) {
         NS_LOG_FUNCTION(this);
-        for (std::map<Ptr<Socket>, std::queue<Packet> >::iterator iter = m_queues.begin(); iter != m_queues.end(); ++iter) {
-            HTTPHeader httpHeader;
-            MPEGHeader mpegHeader;
 
-            if (iter->second.size()) {
-                Ptr<Packet> frame = iter->second.front().Copy();
+        if (g_log.IsEnabled(LOG_INFO)) { // Walks all the connections
+            for (ConnectionMap::iterator iter = m_connections.begin(); iter != m_connections.end(); ++iter) {
+                if (!iter->second.cursor.IsEmpty()) {
+                    NS_LOG_INFO(
+                    "VidId: " << iter->second.cursor.GetVideoId() << " rxAv= " << iter->first->GetRxAvailable() << " queue= "<< iter->second.cursor.GetPending() << " res= " << iter->second.cursor.GetResolution() << " tx= " << iter->second.txBytes);
+                }
+            }
+        }
+
+        ConnectionMap::iterator it = m_connections.find(PeekPointer(socket));
+        if (it == m_connections.end() || m_pacingFactor > 0) { // Paced sends are scheduled events
+            return;
+        }
+        Activate(it->second);
+        Wake();
 
-                frame->RemoveHeader(mpegHeader);
-                frame->RemoveHeader(httpHeader);
+        NS_LOG_INFO("DATA WAS JUST SENT!!!");
+    }
 
-                NS_LOG_INFO(
-                "VidId: " << httpHeader.GetVideoId() << " rxAv= " << iter->first->GetRxAvailable() << " queue= "<< iter->second.size() << " res= " << httpHeader.GetResolution());
+    void DashServer::Activate(Connection &conn) {
+        if (conn.active || conn.cursor.IsEmpty()) {
+            return;
+        }
+        conn.active = true;
+        if (m_scheduler == EDF) {
+            // Ties, and requests without a deadline, keep their arrival order
+            conn.edf = m_deadlines.insert(std::make_pair(conn.cursor.GetDeadline(), &conn));
+        } else {
+            m_active.push_back(&conn);
+        }
+    }
+
+    bool DashServer::SendFrame(Connection &conn, Ptr<Packet> frame) {
+        int bytes;
+        if (conn.socket->GetTxAvailable() < frame->GetSize()) {
+            NS_LOG_INFO("Could not send frame");
+            return false;
+        }
+        if ((bytes = conn.socket->Send(frame)) != (int) frame->GetSize()) {
+            NS_LOG_INFO("Could not send frame");
+            if (bytes != -1) {
+                NS_FATAL_ERROR("Oops, we sent half a frame :(");
             }
+            return false;
+        }
+        conn.cursor.Pop();
+        conn.txBytes += bytes;
+        m_connectionTxTrace(conn.socket, conn.txBytes);
+        return true;
+    }
+
+    uint32_t DashServer::SendPart(Connection &conn, Ptr<Packet> response, uint32_t maxBytes) {
+        uint32_t bytes = std::min(std::min(response->GetSize(), maxBytes), conn.socket->GetTxAvailable());
+        if (bytes == 0) {
+            return 0;
+        }
+        int sent = conn.socket->Send(response->CreateFragment(0, bytes));
+        if (sent <= 0) {
+            NS_LOG_INFO("Could not send segment");
+            return 0;
         }
+        conn.cursor.Pop(sent);
+        conn.txBytes += sent;
+        m_connectionTxTrace(conn.socket, conn.txBytes);
+        return sent;
+    }
 
-        while (!m_queues[socket].empty()) {
-            int bytes;
-            Ptr<Packet> frame = m_queues[socket].front().Copy();
-            if ((bytes = socket->Send(frame)) != (int) frame->GetSize()) {
-                NS_LOG_INFO("Could not send frame");
-                if (bytes != -1) {
-                    NS_FATAL_ERROR("Oops, we sent half a frame :(");
+    uint32_t DashServer::SendFrames(Connection &conn, uint32_t maxBytes, bool segmentOnly, bool &blocked) {
+        uint32_t sent = 0;
+        uint32_t pending = conn.cursor.GetPending();
+        blocked = false;
+
+        while (!conn.cursor.IsEmpty() && (!segmentOnly || conn.cursor.GetPending() == pending)) {
+            Ptr<Packet> frame = conn.cursor.Peek(m_cache);
+            if (conn.cursor.IsWholeSegment()) { // Sent in as many parts as the socket takes
+                uint32_t bytes = SendPart(conn, frame, maxBytes - sent);
+                if (bytes == 0) {
+                    blocked = sent < maxBytes;
+                    break;
                 }
+                sent += bytes;
+                continue;
+            }
+            if (sent + frame->GetSize() > maxBytes) {
                 break;
             }
-            m_queues[socket].pop();
+            if (!SendFrame(conn, frame)) {
+                blocked = true;
+                break;
+            }
+            sent += frame->GetSize();
         }
+        return sent;
+    }
 
-        NS_LOG_INFO("DATA WAS JUST SENT!!!");
+    void DashServer::Pace(Ptr<Socket> socket) {
+        NS_LOG_FUNCTION(this << socket);
+
+        ConnectionMap::iterator it = m_connections.find(PeekPointer(socket));
+        if (it == m_connections.end()) {
+            return;
+        }
+        Connection &conn = it->second;
+
+        while (!conn.cursor.IsEmpty()) {
+            // Bytes per second, for the resolution of the segment being sent
+            double rate = m_pacingFactor * conn.cursor.GetResolution() / 8;
+            NS_ASSERT(rate > 0);
+
+            conn.tokens = std::min<double>(m_bucketDepth,
+                conn.tokens + rate * (Simulator::Now() - conn.lastRefill).GetSeconds());
+            conn.lastRefill = Simulator::Now();
+
+            // Frames larger than the bucket go out once it is full, and leave it in debt
+            Ptr<Packet> frame = conn.cursor.Peek(m_cache);
+            double needed = std::min<double>(frame->GetSize(), m_bucketDepth);
+
+            Time wait;
+            if (conn.tokens < needed) {
+                wait = Seconds((needed - conn.tokens) / rate);
+            } else if (conn.cursor.IsWholeSegment()) { // Sends what the bucket holds
+                uint32_t bytes = SendPart(conn, frame, (uint32_t) conn.tokens);
+                if (bytes == 0) {
+                    wait = Seconds(needed / rate);
+                } else {
+                    conn.tokens -= bytes;
+                    continue;
+                }
+            } else if (!SendFrame(conn, frame)) { // Retry once the frame would have left
+                wait = Seconds(frame->GetSize() / rate);
+            } else {
+                conn.tokens -= frame->GetSize();
+                continue;
+            }
+
+            conn.pacingEvent = Simulator::Schedule(Max(wait, TimeStep(1)),
+                &DashServer::Pace, this, conn.socket);
+            return;
+        }
     }
 
-    void DashServer::SendSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id, Ptr<Socket> socket) {
-        int avg_packetsize = resolution / (50 * 8);
-
-        HTTPHeader http_header_tmp;
-        MPEGHeader mpeg_header_tmp;
-
-        Ptr<UniformRandomVariable> frame_size_gen = CreateObject<UniformRandomVariable> ();
-
-        frame_size_gen->SetAttribute ("Min", DoubleValue(0));
-        frame_size_gen->SetAttribute ("Max", DoubleValue(
-            std::max(
-            std::min(2 * avg_packetsize, MPEG_MAX_MESSAGE)
-            - (int) (mpeg_header_tmp.GetSerializedSize()
-            + http_header_tmp.GetSerializedSize()), 1)));
-
-        for (uint32_t f_id = 0; f_id < MPEG_FRAMES_PER_SEGMENT; f_id++) {
-            uint32_t frame_size = (unsigned) frame_size_gen->GetValue();
-
-            HTTPHeader http_header;
-            http_header.SetMessageType(HTTP_RESPONSE);
-            http_header.SetVideoId(video_id);
-            http_header.SetResolution(resolution);
-            http_header.SetSegmentId(segment_id);
-
-            MPEGHeader mpeg_header;
-            mpeg_header.SetFrameId(f_id);
-            mpeg_header.SetPlaybackTime(
-            MilliSeconds(
-            (f_id + (segment_id * MPEG_FRAMES_PER_SEGMENT))
-            * MPEG_TIME_BETWEEN_FRAMES)); //50 fps
-            mpeg_header.SetType('B');
-            mpeg_header.SetSize(frame_size);
-
-            Ptr<Packet> frame = Create<Packet>(frame_size);
-            frame->AddHeader(http_header);
-            frame->AddHeader(mpeg_header);
-                NS_LOG_INFO(
-                "SENDING PACKET " << f_id << " " << frame->GetSize() << " res=" << http_header.GetResolution() << " size=" << mpeg_header.GetSize() << " avg=" << avg_packetsize);
+    void DashServer::Wake(void) {
+        // The connections that become ready at the same instant, as the
+        // requests of clients that started together, share one pass
+        if (!m_scheduleEvent.IsRunning()) {
+            m_scheduleEvent = Simulator::ScheduleNow(&DashServer::Schedule, this);
+        }
+    }
+
+    void DashServer::Schedule(void) {
+        NS_LOG_FUNCTION(this);
 
-            m_queues[socket].push(*frame);
+        if (m_scheduling) { // Send () may call us back through the socket
+            return;
+        }
+        m_scheduling = true;
+
+        bool blocked;
+
+        // Connections leave the schedule when they run out of frames, or when
+        // their socket is full, and come back with their next request or send
+        // callback.
+        if (m_scheduler == EDF) {
+            // The earliest deadline sends until its socket is full. When it
+            // moves on to its next segment it competes again with its new
+            // deadline.
+            while (!m_deadlines.empty()) {
+                Connection *conn = m_deadlines.begin()->second;
+                m_deadlines.erase(m_deadlines.begin());
+                conn->active = false;
+
+                SendFrames(*conn, std::numeric_limits<uint32_t>::max(), true, blocked);
+                if (!blocked) {
+                    Activate(*conn);
+                }
+            }
+        } else if (m_scheduler == DRR) {
+            // Each turn a connection may send up to m_quantum bytes, plus
+            // whatever it did not use in its previous turns. During its turn
+            // it is out of m_active, and not active, as in the others.
+            while (!m_active.empty()) {
+                Connection *conn = m_active.front();
+                m_active.pop_front();
+                conn->active = false;
+
+                conn->deficit += m_quantum;
+                conn->deficit -= SendFrames(*conn, conn->deficit, false, blocked);
+
+                if (conn->cursor.IsEmpty()) {
+                    conn->deficit = 0;
+                } else if (!blocked) {
+                    conn->active = true;
+                    m_active.push_back(conn);
+                }
+            }
+        } else {
+            // Each connection sends until its socket is full
+            while (!m_active.empty()) {
+                Connection *conn = m_active.front();
+                m_active.pop_front();
+                conn->active = false;
+
+                SendFrames(*conn, std::numeric_limits<uint32_t>::max(), false, blocked);
+            }
+        }
+
+        m_scheduling = false;
+    }
+
+    void DashServer::CancelSegment(Connection &conn, uint32_t video_id, uint32_t segment_id) {
+        NS_LOG_FUNCTION(this << video_id << segment_id);
+        uint32_t cancelled = conn.cursor.Cancel(video_id, segment_id);
+        NS_LOG_INFO("CANCELLED SEGMENT " << segment_id << " requests=" << cancelled);
+
+        // The connection competes with the deadline of its new front segment
+        if (cancelled > 0 && conn.active && m_scheduler == EDF) {
+            m_deadlines.erase(conn.edf);
+            conn.active = false;
+            Activate(conn);
+        }
+    }
+
+    void DashServer::SendSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+        const HTTPRequestHeader &request, Ptr<Socket> socket) {
+        Time deadline = request.GetDeadline();
+        NS_LOG_INFO("SENDING SEGMENT " << segment_id << " res=" << resolution << " deadline=" << deadline.GetSeconds());
+
+        Connection &conn = GetConnection(socket);
+        conn.cursor.Push(video_id, resolution, segment_id, deadline, request.IsWholeSegment(),
+            request.GetFirstFrame(), request.GetFrameCount());
+
+        if (m_pacingFactor > 0) {
+            if (!conn.pacingEvent.IsRunning()) {
+                Pace(socket);
+            }
+            return;
         }
-        DataSend(socket, 0);
+        Activate(conn);
+        Wake();
     }
 
 } // Namespace ns3
@@ -30,10 +30,16 @@
 
 #include <ns3/data-rate.h>
 
+#include "segment-cache.h"
+#include "segment-cursor.h"
+#include "http-request-parser.h"
+
 // #include "video-stream-dash.h"
 
+#include <deque>
 #include <map>
 #include <queue>
+#include <unordered_map>
 
 
 namespace ns3
@@ -79,6 +85,32 @@ namespace ns3
 
             virtual ~DashServer();
 
+            /**
+            * TracedCallback signature for the bytes served to a connection.
+            *
+            * \param [in] socket The accepted socket of the connection.
+            * \param [in] bytes The bytes sent to the socket so far.
+            */
+            typedef void (* ConnectionTxTracedCallback)(Ptr<Socket> socket, uint64_t bytes);
+
+            /**
+            * The order in which the connections that can send are served.
+            *
+            * The order only holds within one pass, over the connections
+            * ready at the same instant. Their frames then wait in the
+            * buffers of their sockets, and TCP shares the bottleneck between
+            * the connections whatever order they were filled in. EDF thus
+            * decides which segment starts first, not which one is drained
+            * first, and does little for the stalls of the clients behind a
+            * shared link.
+            */
+            enum SchedulerType
+            {
+                FIFO,   // In the order they became ready, each until its socket is full
+                DRR,    // Deficit round robin, m_quantum bytes per turn
+                EDF     // Earliest playback deadline of the requested segment first, see above
+            };
+
             /**
             * \return pointer to listening socket
             */
@@ -100,7 +132,10 @@ namespace ns3
             void HandleRead(Ptr<Socket>);   // Called when a request is received
             void DataSend(Ptr<Socket>, uint32_t); // Called when a new segment is transmitted
                                      // or when new space is aveilable in the buffer
-            void SendSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id, Ptr<Socket> socket);  // Sends the segment back to the client
+            void SendSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+                const HTTPRequestHeader &request, Ptr<Socket> socket);  // Sends the segment, or the requested frames of it, back to the client
+            void Schedule(void);    // Sends frames of the active connections, in the order of m_scheduler
+            void Wake(void);        // Runs Schedule () once the events of this instant are handled
             void HandleAccept(Ptr<Socket>, const Address& from); // Called hen a new connection is accepted
             void HandlePeerClose(Ptr<Socket>); // Called when the connection is closed by the peer.
             void HandlePeerError(Ptr<Socket>); // Called when there is a peer error
@@ -135,8 +170,46 @@ namespace ns3
             bool        f_connected;
             uint32_t    f_packetSent;
 
-            // A structure that contains the generated MPEG frames, for each client.
-            std::map<Ptr<Socket>, std::queue<Packet> > m_queues;
+            // The state of an accepted socket
+            struct Connection
+            {
+                Ptr<Socket> socket;
+                HttpRequestParser parser; // The requests it sent, as they arrive
+                SegmentCursor cursor;   // The requested segments, and the next frame to send
+                uint32_t deficit;       // Bytes the connection may still send in its turn
+                bool active;            // True if it is waiting for its turn in m_active
+                uint64_t txBytes;       // Bytes served to the connection
+                std::multimap<Time, Connection *>::iterator edf; // Its place in m_deadlines
+                double tokens;          // Bytes in the token bucket, when paced
+                Time lastRefill;        // When the tokens were last added
+                EventId pacingEvent;    // The next paced send
+            };
+
+            // Keyed by the raw pointer, the Connection holds the reference
+            typedef std::unordered_map<Socket *, Connection> ConnectionMap;
+
+            Connection& GetConnection(Ptr<Socket> socket);  // Creates it on the first call
+            void RemoveConnection(Ptr<Socket> socket);
+            void Activate(Connection &conn);        // Joins the schedule, if it has frames to send
+            bool SendFrame(Connection &conn, Ptr<Packet> frame);  // False if the socket is full
+            uint32_t SendPart(Connection &conn, Ptr<Packet> response, uint32_t maxBytes); // Of a whole segment response, zero if the socket is full
+            uint32_t SendFrames(Connection &conn, uint32_t maxBytes, bool segmentOnly, bool &blocked);
+            void Pace(Ptr<Socket> socket);          // Sends the frames its token bucket allows
+            void CancelSegment(Connection &conn, uint32_t video_id, uint32_t segment_id); // Drops its frames not sent yet
+
+            ConnectionMap m_connections;
+            std::deque<Connection *> m_active;     // Connections with frames to send, in turn order
+            std::multimap<Time, Connection *> m_deadlines; // The same, by deadline, for EDF
+            SchedulerType m_scheduler;
+            double m_pacingFactor;                  // Pacing rate, over the requested resolution
+            uint32_t m_bucketDepth;                 // Largest paced burst, in bytes
+            uint32_t m_quantum;                     // Bytes added to the deficit at each turn
+            bool m_scheduling;                      // True while Schedule () runs
+            EventId m_scheduleEvent;                // The pass of the connections ready at this instant
+
+            TracedCallback<Ptr<Socket>, uint64_t> m_connectionTxTrace;
+
+            Ptr<SegmentCache> m_cache;  // The frames of the recently requested segments
 
             std::map<Ptr<Socket>, NodeType> nodeMap;
     };
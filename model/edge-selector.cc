@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "edge-selector.h"
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("EdgeSelector");
+
+    EdgeSelector::Stats::Stats() :
+        rtt(0), throughput(0), hasRtt(false), hasThroughput(false), updated(-Time::Max()) {
+    }
+
+    EdgeSelector::EdgeSelector() :
+        m_margin(0.1), m_weight(0.25) {
+    }
+
+    void EdgeSelector::SetMargin(double margin) {
+        m_margin = margin;
+    }
+
+    void EdgeSelector::SetWeight(double weight) {
+        NS_ASSERT(weight > 0 && weight <= 1);
+        m_weight = weight;
+    }
+
+    EdgeSelector::Stats& EdgeSelector::GetStats(uint32_t edge) {
+        if (edge >= m_edges.size()) {
+            m_edges.resize(edge + 1);
+        }
+        return m_edges[edge];
+    }
+
+    void EdgeSelector::AddRtt(uint32_t edge, Time now, Time rtt) {
+        NS_LOG_FUNCTION(this << edge << now << rtt);
+        Stats &stats = GetStats(edge);
+        stats.rtt = stats.hasRtt ? (1 - m_weight) * stats.rtt + m_weight * rtt.GetSeconds() : rtt.GetSeconds();
+        stats.hasRtt = true;
+        stats.updated = now;
+    }
+
+    void EdgeSelector::AddThroughput(uint32_t edge, Time now, double throughput) {
+        NS_LOG_FUNCTION(this << edge << now << throughput);
+        if (throughput <= 0) {
+            return;
+        }
+        Stats &stats = GetStats(edge);
+        stats.throughput = stats.hasThroughput ?
+            (1 - m_weight) * stats.throughput + m_weight * throughput : throughput;
+        stats.hasThroughput = true;
+        stats.updated = now;
+    }
+
+    bool EdgeSelector::HasData(uint32_t edge) const {
+        return edge < m_edges.size() && m_edges[edge].hasRtt && m_edges[edge].hasThroughput;
+    }
+
+    Time EdgeSelector::GetLastUpdate(uint32_t edge) const {
+        return edge < m_edges.size() ? m_edges[edge].updated : -Time::Max();
+    }
+
+    Time EdgeSelector::GetRtt(uint32_t edge) const {
+        return edge < m_edges.size() ? Seconds(m_edges[edge].rtt) : Seconds(0);
+    }
+
+    double EdgeSelector::GetThroughput(uint32_t edge) const {
+        return edge < m_edges.size() ? m_edges[edge].throughput : 0;
+    }
+
+    Time EdgeSelector::PredictFetchTime(uint32_t edge, double bits) const {
+        if (!HasData(edge)) {
+            return Time::Max();
+        }
+        return Seconds(m_edges[edge].rtt + bits / m_edges[edge].throughput);
+    }
+
+    uint32_t EdgeSelector::Select(uint32_t current, uint32_t candidate, double bits) const {
+        if (!HasData(current) || !HasData(candidate)) {
+            return current;
+        }
+        double now = PredictFetchTime(current, bits).GetSeconds();
+        double then = PredictFetchTime(candidate, bits).GetSeconds();
+        return then < now * (1 - m_margin) ? candidate : current;
+    }
+
+} // namespace ns3
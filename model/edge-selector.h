@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef EDGE_SELECTOR_H
+#define EDGE_SELECTOR_H
+
+#include "ns3/nstime.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+    /**
+    * \ingroup dash
+    *
+    * \brief The round trip time and throughput of the endpoints a client can
+    * fetch its segments from, and the choice between them.
+    *
+    * The samples come from the segments the client downloads and from the
+    * probes it sends, and are smoothed with an exponentially weighted moving
+    * average. The fetch time of a segment on an endpoint is predicted as its
+    * round trip time plus the segment bits over its throughput.
+    */
+    class EdgeSelector
+    {
+        public:
+            EdgeSelector();
+
+            /**
+            * \param margin the relative improvement of the predicted fetch
+            * time that an endpoint must offer to be selected.
+            */
+            void SetMargin(double margin);
+
+            /**
+            * \param weight the weight of a new sample in the averages, in (0, 1].
+            */
+            void SetWeight(double weight);
+
+            /**
+            * \brief Adds the time from a request to the arrival of its first frame.
+            */
+            void AddRtt(uint32_t edge, Time now, Time rtt);
+
+            /**
+            * \brief Adds the bits per second of a transfer, once its first
+            * frame has arrived.
+            */
+            void AddThroughput(uint32_t edge, Time now, double throughput);
+
+            /**
+            * \return true if the endpoint has both a round trip time and a
+            * throughput.
+            */
+            bool HasData(uint32_t edge) const;
+
+            /**
+            * \return the time of the last sample of the endpoint, or
+            * -Time::Max () if it has none.
+            */
+            Time GetLastUpdate(uint32_t edge) const;
+
+            Time GetRtt(uint32_t edge) const;
+            double GetThroughput(uint32_t edge) const;
+
+            /**
+            * \return the predicted time to fetch that many bits, or Time::Max ()
+            * if the endpoint has no data.
+            */
+            Time PredictFetchTime(uint32_t edge, double bits) const;
+
+            /**
+            * \return the endpoint to fetch the next segment from: the current
+            * one, unless another one predicts a fetch time shorter by the margin.
+            */
+            uint32_t Select(uint32_t current, uint32_t candidate, double bits) const;
+
+        private:
+            struct Stats
+            {
+                Stats();
+
+                double rtt;         // In seconds
+                double throughput;  // In bits per second
+                bool hasRtt;
+                bool hasThroughput;
+                Time updated;
+            };
+
+            Stats& GetStats(uint32_t edge);     // Adds the endpoint on its first sample
+
+            std::vector<Stats> m_edges;
+            double m_margin;
+            double m_weight;
+    };
+
+} // namespace ns3
+
+#endif /* EDGE_SELECTOR_H */
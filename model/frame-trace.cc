@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "frame-trace.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("FrameTrace");
+
+    static const char FRAME_TRACE_MAGIC[8] = "DASHFTR";
+    static const uint32_t FRAME_TRACE_VERSION = 1;
+
+    std::map<std::string, Ptr<FrameTrace> > FrameTrace::s_traces;
+
+    Ptr<FrameTrace> FrameTrace::Open(const std::string &path) {
+        NS_LOG_FUNCTION(path);
+
+        std::map<std::string, Ptr<FrameTrace> >::iterator it = s_traces.find(path);
+        if (it != s_traces.end()) {
+            return it->second;
+        }
+        Ptr<FrameTrace> trace = Ptr<FrameTrace>(new FrameTrace(path), false);
+        s_traces[path] = trace;
+        return trace;
+    }
+
+    FrameTrace::FrameTrace(const std::string &path) :
+        m_map(0), m_length(0), m_header(0), m_representations(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            NS_FATAL_ERROR("Could not open the frame trace " << path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0 || (uint64_t) st.st_size < sizeof(FileHeader)) {
+            close(fd);
+            NS_FATAL_ERROR("The frame trace " << path << " is truncated");
+        }
+        m_length = st.st_size;
+        m_map = mmap(0, m_length, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);  // The mapping keeps the file open
+        if (m_map == MAP_FAILED) {
+            NS_FATAL_ERROR("Could not map the frame trace " << path);
+        }
+
+        m_header = static_cast<const FileHeader *>(m_map);
+        m_representations = reinterpret_cast<const Representation *>(m_header + 1);
+
+        if (std::memcmp(m_header->magic, FRAME_TRACE_MAGIC, sizeof(FRAME_TRACE_MAGIC)) != 0
+            || m_header->version != FRAME_TRACE_VERSION) {
+            NS_FATAL_ERROR(path << " is not a frame trace, see FrameTrace::Convert ()");
+        }
+        if (m_header->representations == 0 || sizeof(FileHeader)
+            + (uint64_t) m_header->representations * sizeof(Representation) > m_length) {
+            NS_FATAL_ERROR("The frame trace " << path << " has no representations");
+        }
+        for (uint32_t i = 0; i < m_header->representations; i++) {
+            const Representation &rep = m_representations[i];
+            if (rep.frames == 0 || rep.offset % sizeof(Frame) != 0
+                || rep.offset + (uint64_t) rep.frames * sizeof(Frame) > m_length) {
+                NS_FATAL_ERROR("The frame trace " << path << " is corrupt at bitrate " << rep.bitrate);
+            }
+        }
+        NS_LOG_INFO("Mapped " << m_length << " bytes of frame trace " << path);
+    }
+
+    FrameTrace::~FrameTrace() {
+        munmap(m_map, m_length);
+    }
+
+    const FrameTrace::Representation* FrameTrace::Find(uint32_t bitrate) const {
+        // The highest bitrate that does not exceed the requested one
+        uint32_t low = 0, high = m_header->representations;
+        while (high - low > 1) {
+            uint32_t mid = (low + high) / 2;
+            if (m_representations[mid].bitrate <= bitrate) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+        return &m_representations[low];
+    }
+
+    void FrameTrace::GetFrame(uint32_t bitrate, uint64_t frame_id, uint32_t &size, uint32_t &type) const {
+        const Representation *rep = Find(bitrate);
+        const Frame *frames = reinterpret_cast<const Frame *>(static_cast<const char *>(m_map) + rep->offset);
+        const Frame &frame = frames[frame_id % rep->frames];
+        size = frame.size;
+        type = frame.type;
+    }
+
+    uint32_t FrameTrace::GetRepresentations(void) const {
+        return m_header->representations;
+    }
+
+    uint32_t FrameTrace::GetBitrate(uint32_t index) const {
+        NS_ASSERT(index < m_header->representations);
+        return m_representations[index].bitrate;
+    }
+
+    uint32_t FrameTrace::GetFrames(uint32_t bitrate) const {
+        return Find(bitrate)->frames;
+    }
+
+    bool FrameTrace::Convert(const std::string &textPath, const std::string &binaryPath) {
+        NS_LOG_FUNCTION(textPath << binaryPath);
+
+        std::ifstream in(textPath.c_str());
+        if (!in) {
+            NS_LOG_ERROR("Could not open " << textPath);
+            return false;
+        }
+
+        std::map<uint32_t, std::vector<Frame> > representations;
+        std::string line;
+        uint32_t lineNo = 0;
+        while (std::getline(in, line)) {
+            lineNo++;
+            std::istringstream fields(line);
+            uint32_t bitrate;
+            char type;
+            uint32_t size;
+            fields >> std::ws;
+            if (fields.peek() == std::char_traits<char>::eof() || fields.peek() == '#') {
+                continue;
+            }
+            if (!(fields >> bitrate >> type >> size)) {
+                NS_LOG_ERROR(textPath << ":" << lineNo << ": expected <bitrate> <type> <size>");
+                return false;
+            }
+            Frame frame;
+            std::memset(&frame, 0, sizeof(frame));
+            frame.size = size;
+            frame.type = type;
+            representations[bitrate].push_back(frame);
+        }
+        if (representations.empty()) {
+            NS_LOG_ERROR(textPath << " has no frames");
+            return false;
+        }
+
+        FileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, FRAME_TRACE_MAGIC, sizeof(FRAME_TRACE_MAGIC));
+        header.version = FRAME_TRACE_VERSION;
+        header.representations = representations.size();
+
+        std::vector<Representation> table;
+        uint64_t offset = sizeof(FileHeader) + representations.size() * sizeof(Representation);
+        for (std::map<uint32_t, std::vector<Frame> >::const_iterator it = representations.begin();
+            it != representations.end(); ++it) {
+            Representation rep = { it->first, (uint32_t) it->second.size(), offset };
+            table.push_back(rep);
+            offset += it->second.size() * sizeof(Frame);
+        }
+
+        std::ofstream out(binaryPath.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(&table[0]), table.size() * sizeof(Representation));
+        for (std::map<uint32_t, std::vector<Frame> >::const_iterator it = representations.begin();
+            it != representations.end(); ++it) {
+            out.write(reinterpret_cast<const char *>(&it->second[0]), it->second.size() * sizeof(Frame));
+        }
+        if (!out) {
+            NS_LOG_ERROR("Could not write " << binaryPath);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace ns3
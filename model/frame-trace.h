@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <map>
+#include <string>
+
+namespace ns3
+{
+
+    /**
+    * \ingroup dash
+    *
+    * \brief The per-frame sizes and types of every representation of a video,
+    * as logged by its encoder.
+    *
+    * The trace is a binary file that is memory-mapped read only, and shared by
+    * all the servers of the process that open the same path, so its frames
+    * cost no memory per client and are paged in as they are read. The file is
+    * made from a text trace by Convert (), see examples/frame-trace-convert.cc.
+    *
+    * The binary format, in host byte order, is a 16 byte header ("DASHFTR",
+    * a version and the number of representations), a table of 16 byte
+    * representations (bitrate, number of frames, offset of their frames)
+    * sorted by bitrate, and the 8 byte frames (size, type) of each of them.
+    */
+    class FrameTrace : public SimpleRefCount<FrameTrace>
+    {
+        public:
+            ~FrameTrace();
+
+            /**
+            * \return the trace at path, mapping it on its first use.
+            */
+            static Ptr<FrameTrace> Open(const std::string &path);
+
+            /**
+            * \brief Writes the binary trace of a text one.
+            *
+            * Each line of the text trace holds the bitrate of a representation,
+            * and the type ('I', 'P', 'B') and size in bytes of its next frame.
+            * Empty lines and the ones starting with '#' are skipped.
+            *
+            * \return false if the text trace could not be read or the binary
+            * one written.
+            */
+            static bool Convert(const std::string &textPath, const std::string &binaryPath);
+
+            /**
+            * \brief Looks up a frame of the representation with the given
+            * bitrate, or of the highest one below it if there is none.
+            *
+            * Frames past the end of the trace wrap around to its start.
+            */
+            void GetFrame(uint32_t bitrate, uint64_t frame_id, uint32_t &size, uint32_t &type) const;
+
+            uint32_t GetRepresentations(void) const;    // Number of representations
+            uint32_t GetBitrate(uint32_t index) const;  // Of the representation, by rising bitrate
+            uint32_t GetFrames(uint32_t bitrate) const; // Length of the representation
+
+        private:
+            struct FileHeader
+            {
+                char magic[8];
+                uint32_t version;
+                uint32_t representations;
+            };
+
+            struct Representation
+            {
+                uint32_t bitrate;
+                uint32_t frames;
+                uint64_t offset;    // Of its first frame, from the start of the file
+            };
+
+            struct Frame
+            {
+                uint32_t size;
+                uint8_t type;
+                uint8_t padding[3];
+            };
+
+            FrameTrace(const std::string &path);
+
+            const Representation* Find(uint32_t bitrate) const;
+
+            void *m_map;
+            uint64_t m_length;
+            const FileHeader *m_header;
+            const Representation *m_representations;
+
+            static std::map<std::string, Ptr<FrameTrace> > s_traces;  // Keyed by path
+    };
+
+} // namespace ns3
+
+#endif /* FRAME_TRACE_H */
@@ -34,7 +34,8 @@ namespace ns3
 {
 
     HttpParser::HttpParser() :
-        m_bytes(0), m_app(NULL), m_lastmeasurement("0s") {
+        m_messageSize(0), m_messageIsSegment(false), m_probe(false), m_segmentFrame(0), m_segmentRead(0),
+        m_segmentEnd(0), m_bytesReceived(0), m_app(NULL), m_lastmeasurement("0s") {
         NS_LOG_FUNCTION(this);
     }
 
@@ -47,10 +48,33 @@ namespace ns3
         m_app = app;
     }
 
+    uint64_t HttpParser::GetBytesReceived(void) const {
+        return m_bytesReceived;
+    }
+
+    uint64_t HttpParser::GetBytesCopied(void) const {
+        return m_ring.GetBytesCopied();
+    }
+
+    void HttpParser::SetProbe(bool probe) {
+        NS_LOG_FUNCTION(this << probe);
+        m_probe = probe;
+    }
+
+    void HttpParser::Reset(void) {
+        NS_LOG_FUNCTION(this);
+        m_ring.Clear();
+        m_messageSize = 0;
+        m_messageIsSegment = false;
+        m_probe = false;
+        m_segmentIndex.clear();
+        m_segmentFrame = 0;
+        m_segmentRead = 0;
+        m_segmentEnd = 0;
+    }
+
     void HttpParser::ReadSocket(Ptr<Socket> socket) {
         NS_LOG_FUNCTION(this << socket);
-        Address from;
-        int bytes = socket->RecvFrom(&m_buffer[m_bytes], MPEG_MAX_MESSAGE - m_bytes, 0, from);
 
         MPEGHeader mpeg_header;
         HTTPHeader http_header;
@@ -58,38 +82,117 @@ namespace ns3
         uint32_t headersize = mpeg_header.GetSerializedSize()
                                 + http_header.GetSerializedSize();
 
-        if (bytes > 0) {
-            m_bytes += bytes;
+        Ptr<Packet> packet;
+        Address from;
+        while ((packet = socket->RecvFrom(from))) {
+            uint32_t bytes = packet->GetSize();
+            if (bytes == 0) { // EOF
+                break;
+            }
+            m_ring.Push(packet);
+            m_bytesReceived += bytes;
 
             if (m_lastmeasurement > Time("0s")) {
                 NS_LOG_INFO(
                     Simulator::Now().GetSeconds() << " bytes: " << bytes << " dt: " << (Simulator::Now() - m_lastmeasurement).GetSeconds() << " bitrate: " << (8 * (bytes + headersize)/ (Simulator::Now() - m_lastmeasurement).GetSeconds()));
             }
+            if (!m_probe) { // Of an endpoint that is not requested
+                m_app->ReadReceived(bytes, m_lastmeasurement);
+            }
             m_lastmeasurement = Simulator::Now();
         }
 
         NS_LOG_INFO(
-            "### Buffer space: " << m_bytes << " Queue length " << m_app->GetPlayer().GetQueueSize());
+            "### Buffer space: " << m_ring.GetSize() << " Queue length " << m_app->GetPlayer().GetQueueSize());
+
+        while (true) {
+            if (!m_segmentIndex.empty()) {
+                if (!ReadSegmentFrame()) {
+                    break;
+                }
+                continue;
+            }
+            if (m_ring.GetSize() < headersize) {
+                break;
+            }
+            if (m_messageSize == 0) {
+                m_ring.Peek(mpeg_header.GetSerializedSize())->RemoveHeader(mpeg_header);
+                m_messageIsSegment = mpeg_header.GetType() == MPEG_SEGMENT_RESPONSE;
+                // Of a segment response, only the headers and the index are popped
+                m_messageSize = headersize + (m_messageIsSegment ?
+                    mpeg_header.GetFrameId() * MPEG_SEGMENT_INDEX_ENTRY : mpeg_header.GetSize());
+            }
+            if (m_ring.GetSize() < m_messageSize) {
+                break;
+            }
+            Ptr<Packet> message = m_ring.Pop(m_messageSize);
+            m_messageSize = 0;
+
+            if (m_probe) {
+                m_app->ProbeReceived(message);
+            } else if (m_messageIsSegment) {
+                StartSegment(message);
+            } else {
+                m_app->MessageReceived(message);
+            }
+        }
+    }
+
+    void HttpParser::StartSegment(Ptr<Packet> message) {
+        NS_LOG_FUNCTION(this << message);
+
+        MPEGHeader mpeg_header;
+        m_segmentRead = message->GetSize();
+        message->RemoveHeader(mpeg_header);
+        message->RemoveHeader(m_segmentHttp);
+
+        uint32_t frames = mpeg_header.GetFrameId();
+        NS_ASSERT(message->GetSize() == frames * MPEG_SEGMENT_INDEX_ENTRY);
+        std::vector<uint8_t> index(message->GetSize());
+        if (!index.empty()) {
+            message->CopyData(&index[0], index.size());
+        }
 
-        if (m_bytes < headersize) {
-            return;
+        m_segmentIndex.assign(frames, 0);
+        for (uint32_t f_id = 0; f_id < frames; f_id++) {
+            for (uint32_t b = 0; b < MPEG_SEGMENT_INDEX_ENTRY; b++) {
+                m_segmentIndex[f_id] = (m_segmentIndex[f_id] << 8) | index[f_id * MPEG_SEGMENT_INDEX_ENTRY + b];
+            }
         }
+        m_segmentFrame = 0;
+        m_segmentEnd = 0;
+    }
 
-        Packet headerPacket(m_buffer, headersize);
-        headerPacket.RemoveHeader(mpeg_header);
+    bool HttpParser::ReadSegmentFrame(void) {
+        MPEGHeader mpeg_header;
+        uint32_t headersize = mpeg_header.GetSerializedSize() + m_segmentHttp.GetSerializedSize();
 
-        uint32_t message_size = headersize + mpeg_header.GetSize();
+        uint32_t entry = m_segmentIndex[m_segmentFrame];
+        uint32_t bytes = headersize + (entry & 0xffffff);
+        uint32_t end = m_segmentEnd + bytes;
 
-        if (m_bytes < message_size) {
-            return;
+        // The frame is complete when the response has reached the offset
+        // where it would have ended as a message of its own
+        if (end > m_segmentRead) {
+            if (m_ring.GetSize() < end - m_segmentRead) {
+                return false;
+            }
+            m_ring.Drop(end - m_segmentRead);
+            m_segmentRead = end;
         }
-        Packet message(m_buffer, message_size);
+        m_segmentEnd = end;
 
-        memmove(m_buffer, &m_buffer[message_size], m_bytes - message_size);
-        m_bytes -= message_size;
+        mpeg_header.SetFrameId(m_segmentFrame);
+        mpeg_header.SetPlaybackTime(m_app->GetTiming().GetPlaybackTime(
+            m_segmentHttp.GetSegmentId(), m_segmentFrame));
+        mpeg_header.SetType(entry >> 24);
+        mpeg_header.SetSize(entry & 0xffffff);
 
-        m_app->MessageReceived(message);
+        if (++m_segmentFrame == m_segmentIndex.size()) {
+            m_segmentIndex.clear();
+        }
 
-        ReadSocket(socket);
+        m_app->FrameReceived(mpeg_header, m_segmentHttp, bytes);
+        return true;
     }
 } // namespace ns3
@@ -22,7 +22,11 @@
 #define HTTP_PARSER_H_
 
 #include <ns3/ptr.h>
+#include "http-header.h"
 #include "mpeg-header.h"
+#include "packet-ring.h"
+
+#include <vector>
 
 namespace ns3
 {
@@ -30,6 +34,21 @@ namespace ns3
   class Socket;
   class DashClient;
 
+  /**
+   * \ingroup dash
+   *
+   * \brief Splits the stream of a DashClient socket into the HTTP messages
+   * that carry its MPEG frames.
+   *
+   * The reads are kept in a PacketRing, and each complete message is handed
+   * to DashClient::MessageReceived () as a fragment of them, so the frames
+   * are not copied on their way to the player.
+   *
+   * A whole segment response (see SegmentCache::CreateSegmentResponse) is
+   * read as its frames would have been: each frame goes to
+   * DashClient::FrameReceived () once the bytes it would have taken on its
+   * own have arrived, with its header made from the index of the response.
+   */
   class HttpParser
   {
   public:
@@ -41,9 +60,51 @@ namespace ns3
     void
     SetApp(DashClient *app);
 
+    /**
+     * \return the bytes read from the socket.
+     */
+    uint64_t
+    GetBytesReceived(void) const;
+
+    /**
+     * \return the bytes copied to assemble the messages that were split
+     * across reads.
+     */
+    uint64_t
+    GetBytesCopied(void) const;
+
+    /**
+     * \param probe true to hand the messages to DashClient::ProbeReceived ()
+     * instead of the player, while the socket answers a probe
+     */
+    void
+    SetProbe(bool probe);
+
+    /**
+     * \brief Drops what was read of the current message, when the
+     * connection is lost or replaced by a new one.
+     */
+    void
+    Reset(void);
+
   private:
-    uint8_t m_buffer[MPEG_MAX_MESSAGE];
-    uint32_t m_bytes;
+    void
+    StartSegment(Ptr<Packet> message);  // Reads the headers and index of a segment response
+    bool
+    ReadSegmentFrame(void);  // False until the next frame of the segment has arrived
+
+    PacketRing m_ring;
+    uint32_t m_messageSize; // Of the first message in the ring, or 0 if its header is incomplete
+    bool m_messageIsSegment; // The first message is the start of a segment response
+    bool m_probe;           // The messages answer a probe
+
+    // The segment response being read
+    HTTPHeader m_segmentHttp;
+    std::vector<uint32_t> m_segmentIndex; // The (type << 24) | size of its frames, empty when done
+    uint32_t m_segmentFrame;  // The next frame to deliver
+    uint32_t m_segmentRead;   // Bytes of the response taken from the ring
+    uint32_t m_segmentEnd;    // Where the frames delivered so far would have ended
+    uint64_t m_bytesReceived;
     DashClient *m_app;
 
     Time m_lastmeasurement;
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/header.h"
+#include "http-request-header.h"
+
+NS_LOG_COMPONENT_DEFINE("HTTPRequestHeader");
+
+namespace ns3
+{
+
+  NS_OBJECT_ENSURE_REGISTERED (HTTPRequestHeader)
+  ;
+
+  HTTPRequestHeader::HTTPRequestHeader() :
+      m_flags(0), m_buffer_level(0), m_deadline(0), m_first_frame(0), m_frame_count(0)
+  {
+    NS_LOG_FUNCTION(this);
+  }
+
+  void
+  HTTPRequestHeader::SetBufferLevel(Time buffer_level)
+  {
+    NS_LOG_FUNCTION(this << buffer_level);
+    m_flags |= HAS_DEADLINE;
+    m_buffer_level = buffer_level.GetTimeStep();
+  }
+  Time
+  HTTPRequestHeader::GetBufferLevel(void) const
+  {
+    NS_LOG_FUNCTION(this);
+    return TimeStep(m_buffer_level);
+  }
+
+  void
+  HTTPRequestHeader::SetDeadline(Time deadline)
+  {
+    NS_LOG_FUNCTION(this << deadline);
+    m_flags |= HAS_DEADLINE;
+    m_deadline = deadline.GetTimeStep();
+  }
+  Time
+  HTTPRequestHeader::GetDeadline(void) const
+  {
+    NS_LOG_FUNCTION(this);
+    return HasDeadline() ? TimeStep(m_deadline) : Time::Max();
+  }
+
+  bool
+  HTTPRequestHeader::HasDeadline(void) const
+  {
+    return m_flags & HAS_DEADLINE;
+  }
+
+  void
+  HTTPRequestHeader::SetWholeSegment(bool whole_segment)
+  {
+    NS_LOG_FUNCTION(this << whole_segment);
+    if (whole_segment)
+      {
+        m_flags |= WHOLE_SEGMENT;
+      }
+    else
+      {
+        m_flags &= ~WHOLE_SEGMENT;
+      }
+  }
+  bool
+  HTTPRequestHeader::IsWholeSegment(void) const
+  {
+    return m_flags & WHOLE_SEGMENT;
+  }
+
+  void
+  HTTPRequestHeader::SetFrameRange(uint32_t first_frame, uint32_t frame_count)
+  {
+    NS_LOG_FUNCTION(this << first_frame << frame_count);
+    m_flags |= FRAME_RANGE;
+    m_first_frame = first_frame;
+    m_frame_count = frame_count;
+  }
+  void
+  HTTPRequestHeader::SetCancel(bool cancel)
+  {
+    NS_LOG_FUNCTION(this << cancel);
+    if (cancel)
+      {
+        m_flags |= CANCEL;
+      }
+    else
+      {
+        m_flags &= ~CANCEL;
+      }
+  }
+  bool
+  HTTPRequestHeader::IsCancel(void) const
+  {
+    return m_flags & CANCEL;
+  }
+
+  bool
+  HTTPRequestHeader::HasFrameRange(void) const
+  {
+    return m_flags & FRAME_RANGE;
+  }
+  uint32_t
+  HTTPRequestHeader::GetFirstFrame(void) const
+  {
+    return m_first_frame;
+  }
+  uint32_t
+  HTTPRequestHeader::GetFrameCount(void) const
+  {
+    return m_frame_count;
+  }
+
+  TypeId
+  HTTPRequestHeader::GetTypeId(void)
+  {
+    static TypeId tid =
+        TypeId("ns3::HTTPRequestHeader").SetParent<Header>().AddConstructor<HTTPRequestHeader>();
+    return tid;
+  }
+  TypeId
+  HTTPRequestHeader::GetInstanceTypeId(void) const
+  {
+    return GetTypeId();
+  }
+  void
+  HTTPRequestHeader::Print(std::ostream &os) const
+  {
+    NS_LOG_FUNCTION(this << &os);
+    os << "(flags=" << m_flags << " buffer=" << TimeStep(m_buffer_level).GetSeconds()
+       << " deadline=" << TimeStep(m_deadline).GetSeconds()
+       << " frames=" << m_first_frame << "+" << m_frame_count << ")";
+  }
+  uint32_t
+  HTTPRequestHeader::GetSerializedSize(void) const
+  {
+    NS_LOG_FUNCTION(this);
+    return 4 + 8 + 8 + 4 + 4;
+  }
+
+  void
+  HTTPRequestHeader::Serialize(Buffer::Iterator start) const
+  {
+    NS_LOG_FUNCTION(this << &start);
+    Buffer::Iterator i = start;
+    i.WriteHtonU32(m_flags);
+    i.WriteHtonU64(m_buffer_level);
+    i.WriteHtonU64(m_deadline);
+    i.WriteHtonU32(m_first_frame);
+    i.WriteHtonU32(m_frame_count);
+  }
+  uint32_t
+  HTTPRequestHeader::Deserialize(Buffer::Iterator start)
+  {
+    NS_LOG_FUNCTION(this << &start);
+    Buffer::Iterator i = start;
+    m_flags = i.ReadNtohU32();
+    m_buffer_level = i.ReadNtohU64();
+    m_deadline = i.ReadNtohU64();
+    m_first_frame = i.ReadNtohU32();
+    m_frame_count = i.ReadNtohU32();
+    return GetSerializedSize();
+  }
+
+} // namespace ns3
@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef HTTP_REQUEST_HEADER_H
+#define HTTP_REQUEST_HEADER_H
+
+#include "ns3/header.h"
+#include "ns3/nstime.h"
+
+namespace ns3
+{
+  /**
+   * \ingroup dash
+   * \class HTTPRequestHeader
+   * \brief The optional fields of a segment request.
+   *
+   * The header is carried at the start of the body of an HTTP_REQUEST
+   * message, after its HTTPHeader, so requests keep the same size on the
+   * wire. An all-zero body, as sent by older clients, carries no fields.
+   */
+
+#define HTTP_REQUEST_BODY 100 // The size of the body of a request
+
+  class HTTPRequestHeader : public Header
+  {
+  public:
+    HTTPRequestHeader();
+
+    /**
+     * \param buffer_level the media that the client had buffered ahead of
+     * the requested segment, when it sent the request
+     */
+    void
+    SetBufferLevel(Time buffer_level);
+    Time
+    GetBufferLevel(void) const;
+
+    /**
+     * \param deadline the time when the client will start playing the
+     * requested segment
+     */
+    void
+    SetDeadline(Time deadline);
+    Time
+    GetDeadline(void) const;
+
+    /**
+     * \return true if the client has set the deadline and buffer level
+     */
+    bool
+    HasDeadline(void) const;
+
+    /**
+     * \param whole_segment true to have the segment sent back as a single
+     * response, see SegmentCache::CreateSegmentResponse, instead of one
+     * response per frame
+     */
+    void
+    SetWholeSegment(bool whole_segment);
+    bool
+    IsWholeSegment(void) const;
+
+    /**
+     * \brief Asks for some frames of the segment only, so that a client may
+     * download a segment over several connections.
+     *
+     * \param first_frame the id of the first frame to send
+     * \param frame_count the number of frames to send
+     */
+    void
+    SetFrameRange(uint32_t first_frame, uint32_t frame_count);
+    bool
+    HasFrameRange(void) const;
+    uint32_t
+    GetFirstFrame(void) const;
+    /**
+     * \return the number of frames requested, or 0 for all the frames
+     * from the first one
+     */
+    uint32_t
+    GetFrameCount(void) const;
+
+    /**
+     * \param cancel true to have the server drop the frames of the segment
+     * that it has not started to send, instead of sending the segment.
+     * The frames already sent still arrive.
+     */
+    void
+    SetCancel(bool cancel);
+    bool
+    IsCancel(void) const;
+
+    static TypeId
+    GetTypeId(void);
+
+    virtual uint32_t
+    GetSerializedSize(void) const;
+
+  private:
+    virtual TypeId
+    GetInstanceTypeId(void) const;
+    virtual void
+    Print(std::ostream &os) const;
+    virtual void
+    Serialize(Buffer::Iterator start) const;
+    virtual uint32_t
+    Deserialize(Buffer::Iterator start);
+
+    enum
+    {
+      HAS_DEADLINE = 1,
+      WHOLE_SEGMENT = 2,
+      FRAME_RANGE = 4,
+      CANCEL = 8
+    };
+
+    uint32_t m_flags;
+    uint64_t m_buffer_level;
+    uint64_t m_deadline;
+    uint32_t m_first_frame;
+    uint32_t m_frame_count;
+  };
+
+} // namespace ns3
+
+#endif /* HTTP_REQUEST_HEADER_H */
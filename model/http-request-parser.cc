@@ -0,0 +1,42 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "http-request-parser.h"
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("HttpRequestParser");
+
+    HttpRequestParser::HttpRequestParser() {
+    }
+
+    uint32_t HttpRequestParser::GetRequestSize(void) {
+        HTTPHeader header;
+        return header.GetSerializedSize() + HTTP_REQUEST_BODY;
+    }
+
+    void HttpRequestParser::Push(Ptr<Packet> packet) {
+        NS_LOG_FUNCTION(this << packet);
+        m_ring.Push(packet);
+    }
+
+    bool HttpRequestParser::Next(HTTPHeader &header, HTTPRequestHeader &requestHeader) {
+        NS_LOG_FUNCTION(this);
+
+        uint32_t size = GetRequestSize();
+        if (m_ring.GetSize() < size) {
+            NS_LOG_INFO("Waiting for " << size - m_ring.GetSize() << " bytes of the request");
+            return false;
+        }
+
+        Ptr<Packet> request = m_ring.Pop(size);
+        request->RemoveHeader(header);
+        request->PeekHeader(requestHeader);
+        return true;
+    }
+
+    uint32_t HttpRequestParser::GetBufferedBytes(void) const {
+        return m_ring.GetSize();
+    }
+
+} // namespace ns3
@@ -0,0 +1,60 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef HTTP_REQUEST_PARSER_H
+#define HTTP_REQUEST_PARSER_H
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+
+#include "http-header.h"
+#include "http-request-header.h"
+#include "packet-ring.h"
+
+namespace ns3
+{
+
+    /**
+    * \ingroup dash
+    *
+    * \brief Splits the byte stream of a connection into requests; the server
+    * side counterpart of HttpParser.
+    *
+    * A request is an HTTPHeader followed by an HTTP_REQUEST_BODY bytes body,
+    * that starts with an HTTPRequestHeader. The reads of the connection are
+    * pushed as they arrive, whether they hold part of a request or several
+    * pipelined ones, and the complete requests are then taken with Next ().
+    */
+    class HttpRequestParser
+    {
+        public:
+            HttpRequestParser();
+
+            /**
+            * \brief Appends a read of the connection.
+            */
+            void Push(Ptr<Packet> packet);
+
+            /**
+            * \brief Takes the next complete request.
+            *
+            * \return false if no complete request is buffered.
+            */
+            bool Next(HTTPHeader &header, HTTPRequestHeader &requestHeader);
+
+            /**
+            * \return the bytes of a partial request that are buffered.
+            */
+            uint32_t GetBufferedBytes(void) const;
+
+            /**
+            * \return the size of a request on the wire.
+            */
+            static uint32_t GetRequestSize(void);
+
+        private:
+            PacketRing m_ring;
+    };
+
+} // namespace ns3
+
+#endif /* HTTP_REQUEST_PARSER_H */
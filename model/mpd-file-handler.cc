@@ -1,27 +1,520 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
 #include "mpd-file-handler.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
 
 namespace ns3 {
 
-MpdFileHandler *MpdFileHandler::instance = 0;
+    NS_LOG_COMPONENT_DEFINE("MpdFileHandler");
+
+    namespace {
+
+        /**
+        * Reads the elements of an XML file one at a time. Text, comments,
+        * processing instructions and declarations are skipped, and the
+        * namespace prefixes are dropped from the names.
+        */
+        class XmlReader {
+            public:
+                enum Event { START, END, DONE, ERROR };
+
+                XmlReader(std::istream &in) :
+                    m_in(in.rdbuf()), m_pendingEnd(false) {
+                }
+
+                // START for <a> and <a/>, END for </a> and after <a/>
+                Event Next(void) {
+                    if (m_pendingEnd) {
+                        m_pendingEnd = false;
+                        return END;
+                    }
+                    for (;;) {
+                        int c = Skip('<');
+                        if (c == EOF) {
+                            return DONE;
+                        }
+                        c = m_in->sgetc();
+                        if (c == '?') {
+                            if (!SkipPast("?>")) {
+                                return ERROR;
+                            }
+                        } else if (c == '!') {
+                            m_in->sbumpc();
+                            if (!SkipDeclaration()) {
+                                return ERROR;
+                            }
+                        } else if (c == '/') {
+                            m_in->sbumpc();
+                            ReadName();
+                            return Skip('>') == EOF ? ERROR : END;
+                        } else {
+                            return ReadStartTag() ? START : ERROR;
+                        }
+                    }
+                }
+
+                const std::string& GetName(void) const {
+                    return m_name;
+                }
+
+                bool GetAttribute(const char *name, std::string &value) const {
+                    for (uint32_t i = 0; i < m_attributes.size(); i++) {
+                        if (m_attributes[i].first == name) {
+                            value = m_attributes[i].second;
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+            private:
+                static bool IsSpace(int c) {
+                    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+                }
+
+                static bool IsNameEnd(int c) {
+                    return c == EOF || IsSpace(c) || c == '/' || c == '>' || c == '=';
+                }
+
+                // Consumes up to and including the given character
+                int Skip(char end) {
+                    int c;
+                    while ((c = m_in->sbumpc()) != EOF && c != end) {
+                    }
+                    return c;
+                }
+
+                bool SkipPast(const std::string &end) {
+                    std::string last;   // The last characters read
+                    int c;
+                    while ((c = m_in->sbumpc()) != EOF) {
+                        last += (char) c;
+                        if (last.size() > end.size()) {
+                            last.erase(0, 1);
+                        }
+                        if (last == end) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                // After "<!": a comment, a CDATA section or a DOCTYPE
+                bool SkipDeclaration(void) {
+                    if (m_in->sgetc() == '-') {
+                        return SkipPast("-->");
+                    }
+                    if (m_in->sgetc() == '[') {
+                        return SkipPast("]]>");
+                    }
+                    int depth = 0, c;
+                    while ((c = m_in->sbumpc()) != EOF) {
+                        if (c == '[') {
+                            depth++;
+                        } else if (c == ']') {
+                            depth--;
+                        } else if (c == '>' && depth <= 0) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                std::string ReadName(void) {
+                    std::string name;
+                    int c;
+                    while (!IsNameEnd(c = m_in->sgetc())) {
+                        m_in->sbumpc();
+                        if (c == ':') {
+                            name.clear();   // Drop the namespace prefix
+                        } else {
+                            name += (char) c;
+                        }
+                    }
+                    return name;
+                }
+
+                void SkipSpaces(void) {
+                    while (IsSpace(m_in->sgetc())) {
+                        m_in->sbumpc();
+                    }
+                }
+
+                bool ReadStartTag(void) {
+                    m_name = ReadName();
+                    m_attributes.clear();
+                    for (;;) {
+                        SkipSpaces();
+                        int c = m_in->sbumpc();
+                        if (c == '>') {
+                            return !m_name.empty();
+                        }
+                        if (c == '/') {
+                            m_pendingEnd = true;
+                            return Skip('>') != EOF && !m_name.empty();
+                        }
+                        if (c == EOF) {
+                            return false;
+                        }
+                        m_in->sungetc();
+
+                        std::string name = ReadName();
+                        SkipSpaces();
+                        if (name.empty() || m_in->sbumpc() != '=') {
+                            return false;
+                        }
+                        SkipSpaces();
+                        int quote = m_in->sbumpc();
+                        if (quote != '"' && quote != '\'') {
+                            return false;
+                        }
+                        std::string value;
+                        while ((c = m_in->sbumpc()) != quote) {
+                            if (c == EOF) {
+                                return false;
+                            }
+                            value += (char) c;
+                        }
+                        m_attributes.push_back(std::make_pair(name, Unescape(value)));
+                    }
+                }
+
+                static std::string Unescape(const std::string &value) {
+                    static const char *entities[][2] = { { "&amp;", "&" }, { "&lt;", "<" },
+                        { "&gt;", ">" }, { "&quot;", "\"" }, { "&apos;", "'" } };
+                    std::string::size_type amp = value.find('&');
+                    if (amp == std::string::npos) {
+                        return value;
+                    }
+                    std::string result(value, 0, amp);
+                    for (std::string::size_type i = amp; i < value.size(); i++) {
+                        bool replaced = false;
+                        for (uint32_t e = 0; value[i] == '&' && e < 5 && !replaced; e++) {
+                            std::string::size_type length = std::char_traits<char>::length(entities[e][0]);
+                            if (value.compare(i, length, entities[e][0]) == 0) {
+                                result += entities[e][1];
+                                i += length - 1;
+                                replaced = true;
+                            }
+                        }
+                        if (!replaced) {
+                            result += value[i];
+                        }
+                    }
+                    return result;
+                }
+
+                std::streambuf *m_in;
+                std::string m_name;
+                std::vector<std::pair<std::string, std::string> > m_attributes;
+                bool m_pendingEnd;      // The start tag was empty, <a/>
+        };
+
+        // An ISO 8601 duration as used by the MPD, e.g. "PT1H2M3.5S"
+        bool ParseDuration(const std::string &text, Time &duration) {
+            const char *p = text.c_str();
+            if (*p++ != 'P') {
+                return false;
+            }
+            double seconds = 0;
+            bool time = false;
+            while (*p != '\0') {
+                if (*p == 'T') {
+                    time = true;
+                    p++;
+                    continue;
+                }
+                char *end;
+                double value = std::strtod(p, &end);
+                if (end == p) {
+                    return false;
+                }
+                switch (*end) {
+                    case 'Y': seconds += value * 365 * 86400; break;
+                    case 'D': seconds += value * 86400; break;
+                    case 'H': seconds += value * 3600; break;
+                    case 'M': seconds += value * (time ? 60 : 30 * 86400); break;
+                    case 'S': seconds += value; break;
+                    default: return false;
+                }
+                p = end + 1;
+            }
+            duration = Seconds(seconds);
+            return true;
+        }
+
+        // "30", or "30000/1001"
+        double ParseFrameRate(const std::string &text) {
+            char *end;
+            double rate = std::strtod(text.c_str(), &end);
+            if (*end == '/') {
+                double divisor = std::strtod(end + 1, 0);
+                rate = divisor > 0 ? rate / divisor : 0;
+            }
+            return rate;
+        }
+
+        uint64_t ParseNumber(const XmlReader &reader, const char *name, uint64_t otherwise) {
+            std::string value;
+            return reader.GetAttribute(name, value) ? std::strtoull(value.c_str(), 0, 10) : otherwise;
+        }
+
+    } // namespace
+
+    MpdManifest::MpdManifest() :
+        m_frameRate(0), m_segments(0) {
+    }
+
+    const std::string& MpdManifest::GetPath(void) const {
+        return m_path;
+    }
+
+    Time MpdManifest::GetDuration(void) const {
+        return m_duration;
+    }
+
+    Time MpdManifest::GetSegmentDuration(void) const {
+        return m_runs.empty() ? Time(0) : m_runs[0].duration;
+    }
+
+    Time MpdManifest::GetSegmentDuration(uint32_t segment_id) const {
+        if (m_runs.empty()) {
+            return Time(0);
+        }
+        // The last run that starts at or before the segment
+        uint32_t low = 0, high = m_runs.size();
+        while (high - low > 1) {
+            uint32_t mid = (low + high) / 2;
+            if (m_runs[mid].first <= segment_id) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+        return m_runs[low].duration;
+    }
+
+    uint32_t MpdManifest::GetSegmentCount(void) const {
+        return m_segments;
+    }
+
+    double MpdManifest::GetFrameRate(void) const {
+        return m_frameRate;
+    }
+
+    Ptr<const BitrateLadder> MpdManifest::GetLadder(void) const {
+        return m_ladder;
+    }
+
+    MpdFileHandler *MpdFileHandler::instance = 0;
+
+    MpdFileHandler::MpdFileHandler() :
+        m_parses(0) {
+    }
+
+    MpdFileHandler::~MpdFileHandler() {
+    }
+
+    MpdFileHandler* MpdFileHandler::getInstance() {
+        if (instance == 0) {
+            instance = new MpdFileHandler();
+        }
+        return instance;
+    }
+
+    Ptr<const MpdManifest> MpdFileHandler::Load(const std::string &path) {
+        NS_LOG_FUNCTION(this << path);
+
+        std::map<std::string, Ptr<const MpdManifest> >::iterator it = m_manifests.find(path);
+        if (it != m_manifests.end()) {
+            return it->second;
+        }
+        Ptr<const MpdManifest> manifest = Parse(path);
+        if (manifest) {
+            m_manifests[path] = manifest;
+        }
+        return manifest;
+    }
+
+    bool MpdFileHandler::Assign(uint32_t video_id, const std::string &path) {
+        NS_LOG_FUNCTION(this << video_id << path);
+
+        Ptr<const MpdManifest> manifest = Load(path);
+        if (!manifest) {
+            return false;
+        }
+        m_videos[video_id] = manifest;
+        BitrateLadder::Set(video_id, manifest->GetLadder());
+        return true;
+    }
+
+    Ptr<const MpdManifest> MpdFileHandler::Get(uint32_t video_id) const {
+        std::map<uint32_t, Ptr<const MpdManifest> >::const_iterator it = m_videos.find(video_id);
+        if (it == m_videos.end()) {
+            return 0;
+        }
+        return it->second;
+    }
+
+    uint32_t MpdFileHandler::GetParses(void) const {
+        return m_parses;
+    }
+
+    Ptr<MpdManifest> MpdFileHandler::Parse(const std::string &path) {
+        std::ifstream in(path.c_str());
+        if (!in) {
+            NS_LOG_ERROR("Could not open " << path);
+            return 0;
+        }
+        m_parses++;
+
+        Ptr<MpdManifest> manifest = Ptr<MpdManifest>(new MpdManifest(), false);
+        manifest->m_path = path;
 
+        std::vector<uint32_t> bandwidths;
+        bool videoSet = true;       // The current adaptation set is video
+        bool haveTemplate = false;  // The timing was taken from a template
+        bool inTemplate = false;    // Within that template
+        uint64_t timescale = 1;
+        uint64_t segmentDuration = 0;
+        uint32_t segments = 0;      // Of the timeline so far
+        uint64_t timelineEnd = 0;   // In timescale units, from the S@t of the first S
+        bool openEnded = false;     // The timeline repeats its last S until the end
+        Time periodDuration;
 
-MpdFileHandler::MpdFileHandler()
-{
+        XmlReader reader(in);
+        XmlReader::Event event;
+        std::string value;
+        while ((event = reader.Next()) == XmlReader::START || event == XmlReader::END) {
+            const std::string &name = reader.GetName();
+            if (event == XmlReader::END) {
+                if (name == "AdaptationSet") {
+                    videoSet = true;
+                } else if (name == "SegmentTemplate") {
+                    inTemplate = false;
+                }
+                continue;
+            }
 
-}
+            if (name == "MPD") {
+                if (reader.GetAttribute("mediaPresentationDuration", value)
+                    && !ParseDuration(value, manifest->m_duration)) {
+                    NS_LOG_ERROR(path << ": bad mediaPresentationDuration " << value);
+                    return 0;
+                }
+            } else if (name == "Period") {
+                if (reader.GetAttribute("duration", value)) {
+                    ParseDuration(value, periodDuration);
+                }
+            } else if (name == "AdaptationSet") {
+                if (reader.GetAttribute("contentType", value)) {
+                    videoSet = value == "video";
+                } else if (reader.GetAttribute("mimeType", value)) {
+                    videoSet = value.compare(0, 6, "video/") == 0;
+                }
+                if (videoSet && manifest->m_frameRate == 0 && reader.GetAttribute("frameRate", value)) {
+                    manifest->m_frameRate = ParseFrameRate(value);
+                }
+            } else if (name == "Representation" && videoSet) {
+                if (reader.GetAttribute("mimeType", value) && value.compare(0, 6, "video/") != 0) {
+                    continue;
+                }
+                uint64_t bandwidth = ParseNumber(reader, "bandwidth", 0);
+                if (bandwidth == 0 || bandwidth > 0xffffffffULL) {
+                    NS_LOG_ERROR(path << ": a Representation has no usable bandwidth");
+                    return 0;
+                }
+                bandwidths.push_back(bandwidth);
+                if (manifest->m_frameRate == 0 && reader.GetAttribute("frameRate", value)) {
+                    manifest->m_frameRate = ParseFrameRate(value);
+                }
+            } else if (name == "SegmentTemplate" && videoSet && !haveTemplate) {
+                haveTemplate = inTemplate = true;
+                timescale = std::max<uint64_t>(ParseNumber(reader, "timescale", 1), 1);
+                segmentDuration = ParseNumber(reader, "duration", 0);
+            } else if (name == "S" && inTemplate && !openEnded) {
+                uint64_t d = ParseNumber(reader, "d", 0);
+                if (d == 0) {
+                    NS_LOG_ERROR(path << ": an S element has no duration");
+                    return 0;
+                }
+                // The segments are numbered from the start of the timeline,
+                // which the first S@t sets, and the later ones must follow
+                // on without a gap or an overlap
+                if (reader.GetAttribute("t", value)) {
+                    uint64_t t = std::strtoull(value.c_str(), 0, 10);
+                    if (manifest->m_runs.empty()) {
+                        timelineEnd = t;
+                    } else if (t != timelineEnd) {
+                        NS_LOG_ERROR(path << ": an S element starts at " << t << " instead of "
+                            << timelineEnd << ", timelines with gaps or overlaps are not supported");
+                        return 0;
+                    }
+                }
+                MpdManifest::Run run = { segments, 0, Seconds((double) d / timescale) };
+                long long repeat = reader.GetAttribute("r", value) ? std::strtoll(value.c_str(), 0, 10) : 0;
+                if (repeat == -1) {
+                    openEnded = true;
+                } else if (repeat < 0 || (unsigned long long) repeat >= std::numeric_limits<uint32_t>::max() - segments) {
+                    NS_LOG_ERROR(path << ": bad S@r " << value);
+                    return 0;
+                } else {
+                    run.count = (uint32_t) repeat + 1;
+                    segments += run.count;
+                    timelineEnd += d * run.count;
+                }
+                manifest->m_runs.push_back(run);
+            }
+        }
+        if (event == XmlReader::ERROR) {
+            NS_LOG_ERROR(path << " is not well formed XML");
+            return 0;
+        }
+        if (bandwidths.empty()) {
+            NS_LOG_ERROR(path << " has no video representations");
+            return 0;
+        }
+        manifest->m_ladder = Create<BitrateLadder>(bandwidths);
 
-MpdFileHandler::~MpdFileHandler()
-{
+        if (manifest->m_duration.IsZero()) {
+            manifest->m_duration = periodDuration;
+        }
+        if (manifest->m_runs.empty() && segmentDuration > 0) {
+            MpdManifest::Run run = { 0, 0, Seconds((double) segmentDuration / timescale) };
+            manifest->m_runs.push_back(run);
+            openEnded = true;
+        }
 
-}
+        // An open ended run lasts until the end of the presentation
+        if (!openEnded) {
+            manifest->m_segments = segments;
+        } else if (manifest->m_duration.IsStrictlyPositive()) {
+            double start = 0;
+            for (uint32_t i = 0; i + 1 < manifest->m_runs.size(); i++) {
+                start += manifest->m_runs[i].duration.GetSeconds() * manifest->m_runs[i].count;
+            }
+            MpdManifest::Run &last = manifest->m_runs.back();
+            double count = std::max(std::ceil((manifest->m_duration.GetSeconds() - start)
+                / last.duration.GetSeconds() - 1e-9), 0.0);
+            if (count > std::numeric_limits<uint32_t>::max() - last.first) {
+                NS_LOG_ERROR(path << ": the last S element repeats into too many segments");
+                return 0;
+            }
+            last.count = (uint32_t) count;
+            manifest->m_segments = last.first + last.count;
+        }
 
-MpdFileHandler* MpdFileHandler::getInstance()
-{
-    if (instance == 0) {
-        instance = new MpdFileHandler();
+        NS_LOG_INFO("Parsed " << path << ": " << bandwidths.size() << " representations, "
+            << manifest->m_segments << " segments of " << manifest->GetSegmentDuration().GetSeconds()
+            << "s at " << manifest->m_frameRate << " fps");
+        return manifest;
     }
-    return instance;
-}
 
-}   // endnamespace ns3
+}   // end namespace ns3
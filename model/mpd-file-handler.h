@@ -1,7 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
 #ifndef MPD_FILE_HANDLER_H
 #define MPD_FILE_HANDLER_H
 
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/nstime.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bitrate-ladder.h"
+
 namespace ns3 {
+
+    /**
+    * \ingroup dash
+    *
+    * \brief What the simulation needs of a DASH manifest (MPD): the bitrates
+    * of the video representations, the segment timing and the length of the
+    * presentation.
+    *
+    * A manifest is immutable once parsed, and shared by every client and
+    * server of the videos it was assigned to, see MpdFileHandler.
+    *
+    * The timing is taken from the first SegmentTemplate of the video
+    * adaptation sets, as the representations of a set are segment aligned.
+    * Segment ids count from 0, whatever the startNumber of the template.
+    */
+    class MpdManifest : public SimpleRefCount<MpdManifest> {
+
+        public:
+            const std::string& GetPath(void) const;
+
+            /**
+            * \return the mediaPresentationDuration, or zero if it is not given.
+            */
+            Time GetDuration(void) const;
+
+            /**
+            * \return the duration of the first segment, or zero if the
+            * manifest has no segment template.
+            */
+            Time GetSegmentDuration(void) const;
+
+            /**
+            * \return the duration of a segment, as given by the segment
+            * timeline if there is one.
+            */
+            Time GetSegmentDuration(uint32_t segment_id) const;
+
+            /**
+            * \return the number of segments, or zero if it is unknown.
+            */
+            uint32_t GetSegmentCount(void) const;
+
+            /**
+            * \return the frameRate of the video, or zero if it is not given.
+            */
+            double GetFrameRate(void) const;
+
+            /**
+            * \return the bandwidths of the video representations.
+            */
+            Ptr<const BitrateLadder> GetLadder(void) const;
+
+        private:
+            friend class MpdFileHandler;
+
+            // Consecutive segments of the same duration, as an S element of
+            // a SegmentTimeline, or the whole video for a plain template
+            struct Run {
+                uint32_t first;     // Id of the first segment
+                uint32_t count;     // Of segments, zero for as many as needed
+                Time duration;      // Of each segment
+            };
+
+            MpdManifest();
+
+            std::string m_path;
+            Time m_duration;
+            double m_frameRate;
+            uint32_t m_segments;
+            std::vector<Run> m_runs;
+            Ptr<const BitrateLadder> m_ladder;
+    };
+
+    /**
+    * \ingroup dash
+    *
+    * \brief Parses the MPD files of the simulation, once each, and tells the
+    * clients and servers which manifest a video has.
+    *
+    * The parser reads the file as a stream of XML elements, so it keeps no
+    * document tree in memory. It understands the MPD, Period, AdaptationSet,
+    * Representation, SegmentTemplate and SegmentTimeline elements and skips
+    * the rest.
+    */
     class MpdFileHandler {
 
         public:
@@ -10,10 +106,41 @@ namespace ns3 {
             MpdFileHandler();
             ~MpdFileHandler();
 
+            /**
+            * \return the manifest at path, parsing it on its first use, or 0
+            * if it could not be parsed.
+            */
+            Ptr<const MpdManifest> Load(const std::string &path);
+
+            /**
+            * \brief Sets the manifest of a video, for the clients and servers
+            * that start after the call. The ladder of the video becomes the
+            * one of the manifest, see BitrateLadder::Get.
+            *
+            * \return false if the manifest could not be parsed, in which case
+            * the video is left as it was.
+            */
+            bool Assign(uint32_t video_id, const std::string &path);
+
+            /**
+            * \return the manifest of the video, or 0 if it has none.
+            */
+            Ptr<const MpdManifest> Get(uint32_t video_id) const;
+
+            /**
+            * \return the number of files that have been parsed.
+            */
+            uint32_t GetParses(void) const;
+
         private:
+            Ptr<MpdManifest> Parse(const std::string &path);
 
             static MpdFileHandler* instance;
+
+            std::map<std::string, Ptr<const MpdManifest> > m_manifests;   // Keyed by path
+            std::map<uint32_t, Ptr<const MpdManifest> > m_videos;        // Keyed by video id
+            uint32_t m_parses;
     };
 }   // end namespace ns3
 
-#endif // MPD_FILE_HANDLER_h
+#endif // MPD_FILE_HANDLER_H
@@ -34,9 +34,11 @@ namespace ns3
    * a 64bits time stamp.
    */
 
-#define MPEG_MAX_MESSAGE 100000
+// The timing of the videos that have no other, see VideoTiming
 #define MPEG_FRAMES_PER_SEGMENT 100
 #define MPEG_TIME_BETWEEN_FRAMES 20 // Miliseconds or 50 fps
+#define MPEG_SEGMENT_RESPONSE 'S' // The type of a response that carries a whole segment
+#define MPEG_SEGMENT_INDEX_ENTRY 4 // Bytes per frame in the index of such a response
   class MPEGHeader : public Header
   {
   public:
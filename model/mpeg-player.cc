@@ -25,6 +25,7 @@
 #include "mpeg-header.h"
 #include "mpeg-player.h"
 #include "dash-client.h"
+#include <algorithm>
 #include <cmath>
 
 NS_LOG_COMPONENT_DEFINE("MpegPlayer");
@@ -33,50 +34,113 @@ namespace ns3
 
     MpegPlayer::MpegPlayer() :
       m_state(MPEG_PLAYER_NOT_STARTED), m_interrruptions(0), m_totalRate(0), m_minRate(
-          100000000), m_framesPlayed(0), m_bufferDelay("0s"), end_player(false) {
+          100000000), m_framesPlayed(0), m_queueHead(0), m_queueLength(0), m_bufferDelay("0s"),
+          m_dashClient(NULL), end_player(false), m_frameInterval(MilliSeconds(MPEG_TIME_BETWEEN_FRAMES)),
+          m_analytic(false), m_ticking(false),
+          m_advancing(false) {
         NS_LOG_FUNCTION(this);
     }
 
     MpegPlayer::~MpegPlayer() {
         NS_LOG_FUNCTION(this);
+        m_stallEvent.Cancel();
+        m_wakeupEvent.Cancel();
     }
 
     int MpegPlayer::GetQueueSize() {
-        return m_queue.size();
+        Advance();
+        return m_queueLength;
+    }
+
+    uint32_t MpegPlayer::GetFramesPlayed() {
+        Advance();
+        return m_framesPlayed;
     }
 
     void MpegPlayer::setEndPlayer(bool _end_player) {
         end_player = _end_player;
     }
 
+    void MpegPlayer::SetAnalytic(bool analytic) {
+        NS_ASSERT(m_state == MPEG_PLAYER_NOT_STARTED);
+        m_analytic = analytic;
+    }
+
+    void MpegPlayer::SetFrameInterval(Time interval) {
+        NS_ASSERT(m_state == MPEG_PLAYER_NOT_STARTED && interval.IsStrictlyPositive());
+        m_frameInterval = interval;
+    }
+
+    void MpegPlayer::SchduleBufferWakeup(const Time t, DashClient * client) {
+        Advance();
+        m_bufferDelay = t;
+        m_dashClient = client;
+        ScheduleEvents();
+    }
+
     Time MpegPlayer::GetRealPlayTime(Time playTime) {
+        return GetRealPlayTime(playTime, Simulator::Now());
+    }
+
+    Time MpegPlayer::GetRealPlayTime(Time playTime, Time now) {
         NS_LOG_INFO(
-        " Start: " << m_start_time.GetSeconds() << " Inter: " << m_interruption_time.GetSeconds() << " playtime: " << playTime.GetSeconds() << " now: " << Simulator::Now().GetSeconds() << " actual: " << (m_start_time + m_interruption_time + playTime).GetSeconds());
+        " Start: " << m_start_time.GetSeconds() << " Inter: " << m_interruption_time.GetSeconds() << " playtime: " << playTime.GetSeconds() << " now: " << now.GetSeconds() << " actual: " << (m_start_time + m_interruption_time + playTime).GetSeconds());
 
         return m_start_time + m_interruption_time
             + (m_state == MPEG_PLAYER_PAUSED ?
-                (Simulator::Now() - m_lastpaused) : Seconds(0)) + playTime
-            - Simulator::Now();
+                (now - m_lastpaused) : Seconds(0)) + playTime
+            - now;
     }
 
-    void MpegPlayer::ReceiveFrame(Ptr<Packet> message) {
-        NS_LOG_FUNCTION(this << message);
+    void MpegPlayer::ReceiveFrame(const MPEGHeader &mpeg_header, const HTTPHeader &http_header) {
+        NS_LOG_FUNCTION(this);
         NS_LOG_INFO("Received Frame " << m_state);
 
-        Ptr<Packet> msg = message->Copy();
+        Advance();
+
+        if (m_queueLength == m_queue.size()) {
+            // Unroll the ring into one twice its size
+            std::vector<MpegFrameInfo> queue(std::max<size_t>(2 * m_queue.size(), MPEG_FRAMES_PER_SEGMENT));
+            for (uint32_t i = 0; i < m_queueLength; i++) {
+                queue[i] = m_queue[(m_queueHead + i) % m_queue.size()];
+            }
+            m_queue.swap(queue);
+            m_queueHead = 0;
+        }
+
+        MpegFrameInfo &frame = m_queue[(m_queueHead + m_queueLength) % m_queue.size()];
+        frame.playbackTime = mpeg_header.GetPlaybackTime().GetTimeStep();
+        frame.videoId = http_header.GetVideoId();
+        frame.resolution = http_header.GetResolution();
+        frame.segmentId = http_header.GetSegmentId();
+        frame.frameId = mpeg_header.GetFrameId();
+        frame.size = mpeg_header.GetSize();
+        frame.type = mpeg_header.GetType();
+        m_queueLength++;
 
-        m_queue.push(msg);
         if (m_state == MPEG_PLAYER_PAUSED) {
             NS_LOG_INFO("Play resumed");
             m_state = MPEG_PLAYER_PLAYING;
             m_interruption_time += (Simulator::Now() - m_lastpaused);
-            PlayFrame();
+            if (m_analytic) {
+                m_ticking = true;
+                m_nextTick = Simulator::Now();
+                Advance();
+            } else {
+                PlayFrame();
+            }
         } else if (m_state == MPEG_PLAYER_NOT_STARTED) {
             NS_LOG_INFO("Play started");
             m_state = MPEG_PLAYER_PLAYING;
             m_start_time = Simulator::Now();
-            Simulator::Schedule(Simulator::Now(), &MpegPlayer::PlayFrame, this);
+            if (m_analytic) {
+                m_ticking = true;
+                m_nextTick = Simulator::Now() + Simulator::Now(); // As scheduled below
+            } else {
+                Simulator::Schedule(Simulator::Now(), &MpegPlayer::PlayFrame, this);
+            }
         }
+        ScheduleEvents();
     }
 
     void MpegPlayer::Start(void) {
@@ -85,66 +149,119 @@ namespace ns3
         m_interruption_time = Seconds(0);
     }
 
+    void MpegPlayer::Stop(void) {
+        NS_LOG_FUNCTION(this);
+        Advance();
+        m_state = MPEG_PLAYER_DONE;
+        m_ticking = false;
+        m_stallEvent.Cancel();
+        m_wakeupEvent.Cancel();
+    }
+
     void MpegPlayer::PlayFrame(void) {
         NS_LOG_FUNCTION(this);
 
-        if (m_state == MPEG_PLAYER_DONE) {
+        if (PlayNextFrame(Simulator::Now())) {
+            Simulator::Schedule(m_frameInterval, &MpegPlayer::PlayFrame, this);
+        }
+    }
+
+    void MpegPlayer::Advance(void) {
+        if (!m_analytic || m_advancing) {
             return;
         }
+        m_advancing = true;
+        while (m_ticking && m_nextTick <= Simulator::Now()) {
+            Time now = m_nextTick;
+            m_nextTick += m_frameInterval;
+            m_ticking = PlayNextFrame(now);
+        }
+        m_advancing = false;
+    }
+
+    void MpegPlayer::ScheduleEvents(void) {
+        if (!m_analytic || !m_ticking || m_state == MPEG_PLAYER_DONE) {
+            return;
+        }
+
+        // The frame that finds the buffer empty. Received frames only delay
+        // it, so an earlier event just checks again when it fires.
+        if (!m_stallEvent.IsRunning()) {
+            Time stall = m_nextTick + TimeStep(m_frameInterval.GetTimeStep() * (int64_t) m_queueLength);
+            m_stallEvent = Simulator::Schedule(stall - Simulator::Now(), &MpegPlayer::HandleEvent, this);
+        }
 
-        if (m_queue.empty()) {
+        if (m_bufferDelay <= Time("0s") || !m_dashClient) {
+            return;
+        }
+        // The first buffered frame that triggers the wakeup, if any. Later
+        // frames are checked again when they are received.
+        for (uint32_t i = 0; i < m_queueLength; i++) {
+            Time tick = m_nextTick + TimeStep(m_frameInterval.GetTimeStep() * (int64_t) i);
+            const MpegFrameInfo &frame = m_queue[(m_queueHead + i) % m_queue.size()];
+            if (GetRealPlayTime(TimeStep(frame.playbackTime), tick) < m_bufferDelay) {
+                if (!m_wakeupEvent.IsRunning() || m_wakeupEvent.GetTs() > (uint64_t) tick.GetTimeStep()) {
+                    m_wakeupEvent.Cancel();
+                    m_wakeupEvent = Simulator::Schedule(tick - Simulator::Now(), &MpegPlayer::HandleEvent, this);
+                }
+                break;
+            }
+        }
+    }
+
+    void MpegPlayer::HandleEvent(void) {
+        NS_LOG_FUNCTION(this);
+        Advance();
+        ScheduleEvents();
+    }
+
+    bool MpegPlayer::PlayNextFrame(Time now) {
+        if (m_state == MPEG_PLAYER_DONE) {
+            return false;
+        }
+
+        if (m_queueLength == 0) {
 
             if(end_player) {
-                return;
+                return false;
             }
 
-            NS_LOG_INFO(Simulator::Now().GetSeconds() << " No frames to play");
+            NS_LOG_INFO(now.GetSeconds() << " No frames to play");
             m_state = MPEG_PLAYER_PAUSED;
-            m_lastpaused = Simulator::Now();
+            m_lastpaused = now;
             m_interrruptions++;
 
-            return;
+            return false;
         }
 
-        Ptr<Packet> message = m_queue.front();
-        m_queue.pop();
-
-        MPEGHeader mpeg_header;
-        HTTPHeader http_header;
+        const MpegFrameInfo frame = m_queue[m_queueHead];
+        m_queueHead = (m_queueHead + 1) % m_queue.size();
+        m_queueLength--;
 
-        message->RemoveHeader(mpeg_header);
-        message->RemoveHeader(http_header);
-
-        m_totalRate += http_header.GetResolution();
-        if (http_header.GetSegmentId() > 0) // Discard the first segment for the minRate
+        m_totalRate += frame.resolution;
+        if (frame.segmentId > 0) // Discard the first segment for the minRate
         {                                 // calculation, as it is always the minimum rate
             m_minRate =
-                http_header.GetResolution() < m_minRate ?
-                http_header.GetResolution() : m_minRate;
+                frame.resolution < m_minRate ?
+                frame.resolution : m_minRate;
         }
         m_framesPlayed++;
 
-        /*std::cerr << "res= " << http_header.GetResolution() << " tot="
+        /*std::cerr << "res= " << frame.resolution << " tot="
         << m_totalRate << " played=" << m_framesPlayed << std::endl;*/
 
-        Time b_t = GetRealPlayTime(mpeg_header.GetPlaybackTime());
+        Time b_t = GetRealPlayTime(TimeStep(frame.playbackTime), now);
 
         if (m_bufferDelay > Time("0s") && b_t < m_bufferDelay && m_dashClient) {
-            m_dashClient->RequestSegment();
             m_bufferDelay = Seconds(0);
+            DashClient *client = m_dashClient;
             m_dashClient = NULL;
+            client->RequestSegment();
         }
 
         NS_LOG_INFO(
-        Simulator::Now().GetSeconds() << " PLAYING FRAME: " << " VidId: " << http_header.GetVideoId() << " SegId: " << http_header.GetSegmentId() << " Res: " << http_header.GetResolution() << " FrameId: " << mpeg_header.GetFrameId() << " PlayTime: " << mpeg_header.GetPlaybackTime().GetSeconds() << " Type: " << (char) mpeg_header.GetType() << " interTime: " << m_interruption_time.GetSeconds() << " queueLength: " << m_queue.size());
-
-        /*   std::cout << " frId: " << mpeg_header.GetFrameId()
-        << " playtime: " << mpeg_header.GetPlaybackTime()
-        << " target: " << (m_start_time + m_interruption_time + mpeg_header.GetPlaybackTime()).GetSeconds()
-        << " now: " << Simulator::Now().GetSeconds()
-        << std::endl;
-        */
+        now.GetSeconds() << " PLAYING FRAME: " << " VidId: " << frame.videoId << " SegId: " << frame.segmentId << " Res: " << frame.resolution << " FrameId: " << frame.frameId << " PlayTime: " << TimeStep(frame.playbackTime).GetSeconds() << " Type: " << (char) frame.type << " interTime: " << m_interruption_time.GetSeconds() << " queueLength: " << m_queueLength);
 
-        Simulator::Schedule(MilliSeconds(20), &MpegPlayer::PlayFrame, this);
+        return true;
     }
 } // namespace ns3
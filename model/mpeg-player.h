@@ -21,10 +21,12 @@
 #ifndef MPEG_PLAYER_H_
 #define MPEG_PLAYER_H_
 
-#include <queue>
+#include <vector>
 #include <map>
 #include "ns3/ptr.h"
 #include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
 
 namespace ns3
 {
@@ -34,7 +36,35 @@ namespace ns3
   };
 
   class DashClient;
+  class MPEGHeader;
+  class HTTPHeader;
+
+  /**
+   * \brief What the player needs of a buffered frame, decoded from its
+   * headers when it is received.
+   */
+  struct MpegFrameInfo
+  {
+    int64_t playbackTime; // In time steps
+    uint32_t videoId;
+    uint32_t resolution;
+    uint32_t segmentId;
+    uint32_t frameId;
+    uint32_t size;
+    uint32_t type;
+  };
 
+  /**
+   * \brief Buffers the received frames, and plays one every frame interval
+   * while there are any.
+   *
+   * By default every frame is played by its own event. In analytic mode
+   * the frames are played lazily, whenever the player is queried, from the
+   * times they would have been played at, and events are only scheduled
+   * when the buffer runs out and when a buffer wakeup is due. Both modes
+   * yield the same statistics, as long as they are read through the
+   * accessors that bring the player up to date.
+   */
   class MpegPlayer
   {
   public:
@@ -44,7 +74,10 @@ namespace ns3
     virtual
     ~MpegPlayer();
 
-    void ReceiveFrame(Ptr<Packet> message);
+    /**
+     * \brief Buffers a received frame, given the headers of its message.
+     */
+    void ReceiveFrame(const MPEGHeader &mpeg_header, const HTTPHeader &http_header);
 
     int GetQueueSize();
 
@@ -52,14 +85,34 @@ namespace ns3
 
     void Start();
 
+    /**
+     * \brief Stops playing, after the frames due until now.
+     */
+    void Stop();
+
     Time GetRealPlayTime(Time playTime);
 
-    void inline
-    SchduleBufferWakeup(const Time t, DashClient * client)
-    {
-      m_bufferDelay = t;
-      m_dashClient = client;
-    }
+    void
+    SchduleBufferWakeup(const Time t, DashClient * client);
+
+    /**
+     * \param analytic true to play the frames lazily, instead of with one
+     * event per frame. Must be set before the first frame is received.
+     */
+    void SetAnalytic(bool analytic);
+
+    /**
+     * \param interval the time between frames, MPEG_TIME_BETWEEN_FRAMES ms
+     * by default. Must be set before the first frame is received.
+     */
+    void SetFrameInterval(Time interval);
+
+    /**
+     * \brief Plays the frames that were due until now, in analytic mode.
+     */
+    void Advance();
+
+    uint32_t GetFramesPlayed();
 
     int m_state;
     Time m_interruption_time;
@@ -74,12 +127,36 @@ namespace ns3
     void
     PlayFrame();
 
+    /**
+     * \brief Plays the next frame at time now, or pauses if there is none.
+     *
+     * \return true if the next frame is due a frame interval later.
+     */
+    bool
+    PlayNextFrame(Time now);
+
+    Time GetRealPlayTime(Time playTime, Time now);
+
+    void ScheduleEvents();  // Arms the stall and wakeup events of the analytic mode
+    void HandleEvent();
+
     Time m_lastpaused;
-    std::queue<Ptr<Packet> > m_queue;
+    std::vector<MpegFrameInfo> m_queue; // A ring of frames, doubled when full
+    uint32_t m_queueHead;               // The next frame to play
+    uint32_t m_queueLength;
     Time m_bufferDelay;
     DashClient * m_dashClient;
     bool end_player;
 
+    Time m_frameInterval;
+
+    bool m_analytic;
+    bool m_ticking;         // Analytic mode: a frame is due at m_nextTick
+    bool m_advancing;       // True while Advance () plays frames
+    Time m_nextTick;
+    EventId m_stallEvent;   // When the buffer would run out, or later
+    EventId m_wakeupEvent;  // When the buffer wakeup is due
+
 
   };
 } // namespace ns3
@@ -0,0 +1,210 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "packet-ring.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("PacketRing");
+
+    static const uint32_t PACKET_RING_ORDER = 2;    // A new ring has 2^2 slots
+
+    /**
+    * The free slot arrays of all the rings, by the log2 of their size. The
+    * arrays are only given back with all their slots null.
+    */
+    class PacketSlotPool
+    {
+        public:
+            ~PacketSlotPool() {
+                for (uint32_t order = 0; order < m_free.size(); order++) {
+                    for (uint32_t i = 0; i < m_free[order].size(); i++) {
+                        delete[] m_free[order][i];
+                    }
+                }
+            }
+
+            Ptr<Packet>* Allocate(uint32_t order) {
+                if (order < m_free.size() && !m_free[order].empty()) {
+                    Ptr<Packet> *slots = m_free[order].back();
+                    m_free[order].pop_back();
+                    m_pooled -= (uint64_t) 1 << order;
+                    return slots;
+                }
+                return new Ptr<Packet>[(size_t) 1 << order];
+            }
+
+            void Free(Ptr<Packet> *slots, uint32_t order) {
+                if (order >= m_free.size()) {
+                    m_free.resize(order + 1);
+                }
+                m_free[order].push_back(slots);
+                m_pooled += (uint64_t) 1 << order;
+            }
+
+            uint64_t GetPooled(void) const {
+                return m_pooled;
+            }
+
+            static PacketSlotPool& Get(void) {
+                static PacketSlotPool pool;
+                return pool;
+            }
+
+        private:
+            PacketSlotPool() :
+                m_pooled(0) {
+            }
+
+            std::vector<std::vector<Ptr<Packet> *> > m_free;
+            uint64_t m_pooled;      // Slots in m_free
+    };
+
+    PacketRing::PacketRing() :
+        m_slots(0), m_order(0), m_head(0), m_count(0), m_offset(0), m_size(0), m_bytesCopied(0) {
+    }
+
+    PacketRing::PacketRing(const PacketRing &other) :
+        m_slots(0), m_order(0), m_head(0), m_count(0), m_offset(0), m_size(0), m_bytesCopied(0) {
+        *this = other;
+    }
+
+    PacketRing::~PacketRing() {
+        Clear();
+    }
+
+    PacketRing& PacketRing::operator=(const PacketRing &other) {
+        if (this != &other) {
+            Clear();
+            for (uint32_t i = 0; i < other.m_count; i++) {
+                Push(other.At(i));
+            }
+            m_offset = other.m_offset;
+            m_size = other.m_size;
+            m_bytesCopied = other.m_bytesCopied;
+        }
+        return *this;
+    }
+
+    Ptr<Packet>& PacketRing::At(uint32_t index) {
+        return m_slots[(m_head + index) & (((uint32_t) 1 << m_order) - 1)];
+    }
+
+    const Ptr<Packet>& PacketRing::At(uint32_t index) const {
+        return m_slots[(m_head + index) & (((uint32_t) 1 << m_order) - 1)];
+    }
+
+    void PacketRing::Grow(void) {
+        uint32_t order = m_slots ? m_order + 1 : PACKET_RING_ORDER;
+        Ptr<Packet> *slots = PacketSlotPool::Get().Allocate(order);
+        for (uint32_t i = 0; i < m_count; i++) {
+            slots[i] = At(i);
+            At(i) = 0;
+        }
+        Release();
+        m_slots = slots;
+        m_order = order;
+        m_head = 0;
+    }
+
+    void PacketRing::Release(void) {
+        if (m_slots) {
+            PacketSlotPool::Get().Free(m_slots, m_order);
+            m_slots = 0;
+        }
+    }
+
+    void PacketRing::Push(Ptr<Packet> packet) {
+        NS_LOG_FUNCTION(this << packet);
+        if (packet->GetSize() == 0) {
+            return;
+        }
+        if (!m_slots || m_count == ((uint32_t) 1 << m_order)) {
+            Grow();
+        }
+        At(m_count++) = packet;
+        m_size += packet->GetSize();
+    }
+
+    uint32_t PacketRing::GetSize(void) const {
+        return m_size;
+    }
+
+    Ptr<Packet> PacketRing::Peek(uint32_t bytes) const {
+        NS_LOG_FUNCTION(this << bytes);
+        NS_ASSERT(bytes <= m_size);
+
+        Ptr<Packet> message;
+        uint32_t offset = m_offset;
+        for (uint32_t i = 0; bytes > 0; i++) {
+            const Ptr<Packet> &packet = At(i);
+            uint32_t length = std::min(bytes, packet->GetSize() - offset);
+            Ptr<Packet> fragment = packet->CreateFragment(offset, length);
+            if (message) {
+                m_bytesCopied += length;    // Appending copies the bytes of the fragment
+                message->AddAtEnd(fragment);
+            } else {
+                message = fragment;
+            }
+            bytes -= length;
+            offset = 0;
+        }
+        return message ? message : Create<Packet>();
+    }
+
+    Ptr<Packet> PacketRing::Pop(uint32_t bytes) {
+        Ptr<Packet> message = Peek(bytes);
+        Drop(bytes);
+        return message;
+    }
+
+    void PacketRing::Drop(uint32_t bytes) {
+        NS_LOG_FUNCTION(this << bytes);
+        NS_ASSERT(bytes <= m_size);
+
+        m_size -= bytes;
+        while (bytes > 0) {
+            Ptr<Packet> &packet = At(0);
+            uint32_t length = std::min(bytes, packet->GetSize() - m_offset);
+            m_offset += length;
+            bytes -= length;
+            if (m_offset == packet->GetSize()) {
+                packet = 0;
+                m_head = (m_head + 1) & (((uint32_t) 1 << m_order) - 1);
+                m_count--;
+                m_offset = 0;
+            }
+        }
+        if (m_count == 0) {
+            Release();
+            m_head = 0;
+        }
+    }
+
+    uint64_t PacketRing::GetBytesCopied(void) const {
+        return m_bytesCopied;
+    }
+
+    uint32_t PacketRing::GetCapacity(void) const {
+        return m_slots ? (uint32_t) 1 << m_order : 0;
+    }
+
+    uint64_t PacketRing::GetPooledSlots(void) {
+        return PacketSlotPool::Get().GetPooled();
+    }
+
+    void PacketRing::Clear(void) {
+        for (uint32_t i = 0; i < m_count; i++) {
+            At(i) = 0;
+        }
+        Release();
+        m_head = 0;
+        m_count = 0;
+        m_offset = 0;
+        m_size = 0;
+    }
+
+} // namespace ns3
@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef PACKET_RING_H
+#define PACKET_RING_H
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+
+namespace ns3
+{
+
+    /**
+    * \ingroup dash
+    *
+    * \brief The bytes received on a stream socket, kept as the ring of packets
+    * they arrived in.
+    *
+    * TCP may split a message across reads or coalesce several in one, so
+    * parsers push every read here and pop whole messages once they are
+    * complete. The messages are made of fragments of the received packets,
+    * which share their buffers, so the payloads are never copied.
+    *
+    * The slots of the ring are taken from a pool that all the rings of the
+    * process share. A ring doubles its slots when they are full, and gives
+    * them back as soon as it is empty, so idle connections hold no buffer.
+    */
+    class PacketRing
+    {
+        public:
+            PacketRing();
+            PacketRing(const PacketRing &other);
+            ~PacketRing();
+
+            PacketRing& operator=(const PacketRing &other);
+
+            /**
+            * \brief Appends the bytes of a read to the ring.
+            */
+            void Push(Ptr<Packet> packet);
+
+            /**
+            * \return the number of bytes in the ring.
+            */
+            uint32_t GetSize(void) const;
+
+            /**
+            * \return the first bytes of the ring, leaving them in it.
+            */
+            Ptr<Packet> Peek(uint32_t bytes) const;
+
+            /**
+            * \return the first bytes of the ring, removing them from it.
+            */
+            Ptr<Packet> Pop(uint32_t bytes);
+
+            /**
+            * \brief Removes the first bytes of the ring.
+            */
+            void Drop(uint32_t bytes);
+
+            void Clear(void);
+
+            /**
+            * \return the bytes copied to join the fragments of popped
+            * messages that spanned several packets.
+            */
+            uint64_t GetBytesCopied(void) const;
+
+            /**
+            * \return the number of slots the ring holds, 0 when it is empty.
+            */
+            uint32_t GetCapacity(void) const;
+
+            /**
+            * \return the number of free slots in the shared pool.
+            */
+            static uint64_t GetPooledSlots(void);
+
+        private:
+            Ptr<Packet>& At(uint32_t index);   // The index-th packet, from the first one
+            const Ptr<Packet>& At(uint32_t index) const;
+            void Grow(void);
+            void Release(void);                // Returns the slots to the pool
+
+            Ptr<Packet> *m_slots;              // 2^m_order of them, or none
+            uint32_t m_order;
+            uint32_t m_head;                   // Slot of the first packet
+            uint32_t m_count;                  // Packets in the ring
+            uint32_t m_offset;                 // Bytes of the first packet already popped
+            uint32_t m_size;                   // Bytes in the ring
+            mutable uint64_t m_bytesCopied;
+    };
+
+} // namespace ns3
+
+#endif /* PACKET_RING_H */
@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "read-sample-ring.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("ReadSampleRing");
+
+    ReadSampleRing::ReadSampleRing() :
+        m_samples(64), m_next(0), m_total(0) {
+    }
+
+    void ReadSampleRing::SetCapacity(uint32_t capacity) {
+        NS_ASSERT(capacity > 0);
+        m_samples.assign(capacity, Sample());
+        Clear();
+    }
+
+    uint32_t ReadSampleRing::GetCapacity(void) const {
+        return m_samples.size();
+    }
+
+    void ReadSampleRing::Add(Time time, uint32_t bytes, Time interval) {
+        NS_LOG_FUNCTION(this << time << bytes << interval);
+        Sample &sample = m_samples[m_next];
+        sample.time = time;
+        sample.bytes = bytes;
+        sample.interval = interval;
+        m_next = (m_next + 1) % m_samples.size();
+        m_total++;
+    }
+
+    void ReadSampleRing::Clear(void) {
+        m_next = 0;
+        m_total = 0;
+    }
+
+    uint32_t ReadSampleRing::GetCount(void) const {
+        return std::min<uint64_t>(m_total, m_samples.size());
+    }
+
+    uint64_t ReadSampleRing::GetTotal(void) const {
+        return m_total;
+    }
+
+    const ReadSampleRing::Sample& ReadSampleRing::Get(uint32_t age) const {
+        NS_ASSERT(age < GetCount());
+        return m_samples[(m_next + m_samples.size() - 1 - age) % m_samples.size()];
+    }
+
+    double ReadSampleRing::GetThroughput(Time since) const {
+        uint64_t bytes = 0;
+        std::vector<std::pair<Time, Time> > intervals;
+        for (uint32_t age = 0; age < GetCount() && Get(age).time > since; age++) {
+            const Sample &sample = Get(age);
+            bytes += sample.bytes;
+            intervals.push_back(std::make_pair(Max(sample.time - sample.interval, since), sample.time));
+        }
+
+        // The union of the intervals, in the order they start
+        std::sort(intervals.begin(), intervals.end());
+        Time covered = Seconds(0);
+        Time end = since;
+        for (std::vector<std::pair<Time, Time> >::const_iterator it = intervals.begin(); it != intervals.end(); ++it) {
+            if (it->second > end) {
+                covered += it->second - Max(it->first, end);
+                end = it->second;
+            }
+        }
+        return covered > Seconds(0) ? 8.0 * bytes / covered.GetSeconds() : 0;
+    }
+
+} // namespace ns3
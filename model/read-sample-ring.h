@@ -0,0 +1,76 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef READ_SAMPLE_RING_H
+#define READ_SAMPLE_RING_H
+
+#include "ns3/nstime.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+    /**
+    * \ingroup dash
+    *
+    * \brief The last socket reads of a client, as (bytes, interval) samples,
+    * for the adaptation algorithms that look inside a segment.
+    *
+    * The ring has a fixed number of slots, and a new sample takes the place
+    * of the oldest one once they are all used, so the memory of a client
+    * does not grow with the length of the session.
+    */
+    class ReadSampleRing
+    {
+        public:
+            struct Sample
+            {
+                Time time;          // When the read happened
+                uint32_t bytes;     // Read
+                Time interval;      // Since the previous read of the connection, or its request
+            };
+
+            ReadSampleRing();
+
+            /**
+            * \brief Sets the number of samples kept, dropping the ones there are.
+            */
+            void SetCapacity(uint32_t capacity);
+            uint32_t GetCapacity(void) const;
+
+            void Add(Time time, uint32_t bytes, Time interval);
+            void Clear(void);
+
+            /**
+            * \return the number of samples kept, at most the capacity.
+            */
+            uint32_t GetCount(void) const;
+
+            /**
+            * \return the number of samples added since the ring was made or cleared.
+            */
+            uint64_t GetTotal(void) const;
+
+            /**
+            * \param age 0 for the last sample, 1 for the one before it, and so on.
+            */
+            const Sample& Get(uint32_t age = 0) const;
+
+            /**
+            * \return the bits per second of the samples taken after the given
+            * time, as their bytes over the time their intervals cover from
+            * then on, or 0 if there are none. The intervals of reads of
+            * several connections overlap, and the time they share is
+            * counted once.
+            */
+            double GetThroughput(Time since) const;
+
+        private:
+            std::vector<Sample> m_samples;
+            uint32_t m_next;    // The slot of the next sample
+            uint64_t m_total;
+    };
+
+} // namespace ns3
+
+#endif /* READ_SAMPLE_RING_H */
@@ -0,0 +1,271 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/random-variable-stream.h"
+#include "segment-cache.h"
+#include "http-header.h"
+#include "mpeg-header.h"
+
+#include <limits>
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("SegmentCache");
+    NS_OBJECT_ENSURE_REGISTERED(SegmentCache);
+
+    // ns-3 numbers the automatic streams from 0 up, and maps SetStream (n) to
+    // stream 2^63 + n, so the user's AssignStreams () calls take the low n.
+    // The segments take n from this offset up, clear of both.
+    static const uint64_t SEGMENT_STREAM_OFFSET = (uint64_t) 1 << 62;
+
+    // The fields of the stream of a segment, which fill the 62 bits below
+    // the offset
+    static const uint32_t STREAM_SEGMENT_BITS = 19;
+    static const uint32_t STREAM_RESOLUTION_BITS = 27;  // Up to 134 Mbps
+    static const uint32_t STREAM_VIDEO_BITS = 16;
+
+    MpegSegment::MpegSegment() :
+        bytes(0) {
+    }
+
+    TypeId SegmentCache::GetTypeId(void) {
+        static TypeId tid =
+        TypeId("ns3::SegmentCache").SetParent<Object>().AddConstructor<SegmentCache>()
+            .AddAttribute("MaxBytes",
+            "The size of the cache in bytes, headers included. Zero disables the cache.",
+            UintegerValue(64 * 1024 * 1024),
+            MakeUintegerAccessor(&SegmentCache::m_maxBytes), MakeUintegerChecker<uint64_t>())
+            .AddAttribute("FrameTrace",
+            "A binary frame trace (see FrameTrace::Convert) to read the frame sizes and types from. "
+            "When empty, the frame sizes are uniformly distributed around the average of the resolution.",
+            StringValue(""),
+            MakeStringAccessor(&SegmentCache::SetFrameTrace, &SegmentCache::GetFrameTrace),
+            MakeStringChecker());
+        return tid;
+    }
+
+    SegmentCache::SegmentCache() :
+        m_maxBytes(64 * 1024 * 1024), m_bytes(0), m_hits(0), m_misses(0) {
+        NS_LOG_FUNCTION(this);
+    }
+
+    SegmentCache::~SegmentCache() {
+        NS_LOG_FUNCTION(this);
+    }
+
+    void SegmentCache::DoDispose(void) {
+        NS_LOG_FUNCTION(this);
+        m_entries.clear();
+        m_lru.clear();
+        m_trace = 0;
+        m_bytes = 0;
+
+        // chain up
+        Object::DoDispose();
+    }
+
+    bool SegmentCache::Key::operator<(const Key &other) const {
+        if (video_id != other.video_id) {
+            return video_id < other.video_id;
+        }
+        if (resolution != other.resolution) {
+            return resolution < other.resolution;
+        }
+        return segment_id < other.segment_id;
+    }
+
+    void SegmentCache::SetFrameTrace(std::string path) {
+        m_tracePath = path;
+        m_trace = path.empty() ? 0 : FrameTrace::Open(path);
+    }
+
+    std::string SegmentCache::GetFrameTrace(void) const {
+        return m_tracePath;
+    }
+
+    bool SegmentCache::IsEnabled(void) const {
+        return m_maxBytes > 0;
+    }
+
+    uint64_t SegmentCache::GetHits(void) const {
+        return m_hits;
+    }
+
+    uint64_t SegmentCache::GetMisses(void) const {
+        return m_misses;
+    }
+
+    uint64_t SegmentCache::GetBytes(void) const {
+        return m_bytes;
+    }
+
+    Ptr<MpegSegment> SegmentCache::GetSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id) {
+        NS_LOG_FUNCTION(this << video_id << resolution << segment_id);
+
+        Key key = { video_id, resolution, segment_id };
+        std::map<Key, Entry>::iterator it = m_entries.find(key);
+
+        if (it != m_entries.end()) {
+            m_hits++;
+            m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+            return it->second.segment;
+        }
+
+        m_misses++;
+        Ptr<MpegSegment> segment = CreateSegment(video_id, resolution, segment_id);
+
+        if (segment->bytes <= m_maxBytes) {
+            m_lru.push_front(key);
+            Entry entry = { segment, m_lru.begin() };
+            m_entries[key] = entry;
+            m_bytes += segment->bytes;
+            Evict();
+        }
+
+        NS_LOG_INFO(
+            "VidId: " << video_id << " res= " << resolution << " SegId: " << segment_id << " hits= " << m_hits << " misses= " << m_misses << " bytes= " << m_bytes);
+
+        return segment;
+    }
+
+    void SegmentCache::Evict(void) {
+        while (m_bytes > m_maxBytes && !m_lru.empty()) {
+            std::map<Key, Entry>::iterator it = m_entries.find(m_lru.back());
+            m_bytes -= it->second.segment->bytes;
+            m_entries.erase(it);
+            m_lru.pop_back();
+        }
+    }
+
+    Ptr<UniformRandomVariable> SegmentCache::CreateFrameSizeGenerator(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+        const VideoTiming &timing) const {
+        if (m_trace) {
+            return 0;
+        }
+
+        // The bytes of a frame at the given bitrate
+        int avg_packetsize = (uint64_t) resolution * timing.GetFrameInterval().GetNanoSeconds() / (8 * 1000000000ULL);
+
+        HTTPHeader http_header_tmp;
+        MPEGHeader mpeg_header_tmp;
+
+        Ptr<UniformRandomVariable> frame_size_gen = CreateObject<UniformRandomVariable> ();
+
+        frame_size_gen->SetAttribute ("Min", DoubleValue(0));
+        frame_size_gen->SetAttribute ("Max", DoubleValue(
+            std::max(2 * avg_packetsize
+            - (int) (mpeg_header_tmp.GetSerializedSize()
+            + http_header_tmp.GetSerializedSize()), 1)));
+
+        // Pack the key into a stream number of its own, so that every
+        // request for the same segment draws the same frame sizes.
+        NS_ASSERT_MSG(video_id < (1U << STREAM_VIDEO_BITS), "Video id too large for the stream number");
+        NS_ASSERT_MSG(resolution < (1U << STREAM_RESOLUTION_BITS), "Resolution too large for the stream number");
+        NS_ASSERT_MSG(segment_id < (1U << STREAM_SEGMENT_BITS), "Segment id too large for the stream number");
+        uint64_t stream = ((uint64_t) video_id << (STREAM_RESOLUTION_BITS + STREAM_SEGMENT_BITS))
+            | ((uint64_t) resolution << STREAM_SEGMENT_BITS) | segment_id;
+
+        frame_size_gen->SetStream(SEGMENT_STREAM_OFFSET + stream);
+
+        return frame_size_gen;
+    }
+
+    void SegmentCache::DrawFrame(uint32_t resolution, uint32_t segment_id, uint32_t f_id,
+        Ptr<UniformRandomVariable> frame_size_gen, const VideoTiming &timing, uint32_t &size, uint32_t &type) const {
+        type = 'B';
+        if (m_trace) {
+            m_trace->GetFrame(resolution, (uint64_t) segment_id * timing.GetFramesPerSegment() + f_id,
+                size, type);
+        } else {
+            size = (unsigned) frame_size_gen->GetValue();
+        }
+    }
+
+    Ptr<Packet> SegmentCache::CreateFrame(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+        uint32_t f_id, Ptr<UniformRandomVariable> frame_size_gen, const VideoTiming &timing) const {
+        HTTPHeader http_header;
+        MPEGHeader mpeg_header;
+
+        uint32_t frame_size;
+        uint32_t frame_type;
+        DrawFrame(resolution, segment_id, f_id, frame_size_gen, timing, frame_size, frame_type);
+
+        http_header.SetMessageType(HTTP_RESPONSE);
+        http_header.SetVideoId(video_id);
+        http_header.SetResolution(resolution);
+        http_header.SetSegmentId(segment_id);
+
+        mpeg_header.SetFrameId(f_id);
+        mpeg_header.SetPlaybackTime(timing.GetPlaybackTime(segment_id, f_id));
+        mpeg_header.SetType(frame_type);
+        mpeg_header.SetSize(frame_size);
+
+        Ptr<Packet> frame = Create<Packet>(frame_size);
+        frame->AddHeader(http_header);
+        frame->AddHeader(mpeg_header);
+        NS_LOG_INFO(
+            "CREATED PACKET " << f_id << " " << frame->GetSize() << " res=" << http_header.GetResolution() << " size=" << mpeg_header.GetSize());
+
+        return frame;
+    }
+
+    Ptr<MpegSegment> SegmentCache::CreateSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id) const {
+        VideoTiming timing = VideoTiming::Get(video_id);
+        Ptr<UniformRandomVariable> frame_size_gen = CreateFrameSizeGenerator(video_id, resolution, segment_id, timing);
+
+        Ptr<MpegSegment> segment = Create<MpegSegment>();
+        segment->frames.reserve(timing.GetFramesPerSegment());
+
+        for (uint32_t f_id = 0; f_id < timing.GetFramesPerSegment(); f_id++) {
+            Ptr<Packet> frame = CreateFrame(video_id, resolution, segment_id, f_id, frame_size_gen, timing);
+            segment->bytes += frame->GetSize();
+            segment->frames.push_back(frame);
+        }
+        return segment;
+    }
+
+    Ptr<Packet> SegmentCache::CreateSegmentResponse(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+        const VideoTiming &timing) const {
+        HTTPHeader http_header;
+        MPEGHeader mpeg_header;
+        uint32_t headers = mpeg_header.GetSerializedSize() + http_header.GetSerializedSize();
+
+        Ptr<UniformRandomVariable> frame_size_gen = CreateFrameSizeGenerator(video_id, resolution, segment_id, timing);
+        uint32_t frames = timing.GetFramesPerSegment();
+
+        // The index of the frames, and the bytes they would take as responses of their own
+        std::vector<uint8_t> index(frames * MPEG_SEGMENT_INDEX_ENTRY);
+        uint64_t bytes = 0;
+        for (uint32_t f_id = 0; f_id < frames; f_id++) {
+            uint32_t size, type;
+            DrawFrame(resolution, segment_id, f_id, frame_size_gen, timing, size, type);
+            NS_ASSERT_MSG(size < (1 << 24), "Frame too large for the segment index");
+            uint32_t entry = (type << 24) | size;
+            for (uint32_t b = 0; b < MPEG_SEGMENT_INDEX_ENTRY; b++) {
+                index[f_id * MPEG_SEGMENT_INDEX_ENTRY + b] = entry >> (8 * (MPEG_SEGMENT_INDEX_ENTRY - 1 - b));
+            }
+            bytes += headers + size;
+        }
+        NS_ASSERT(bytes - headers >= index.size() && bytes <= std::numeric_limits<uint32_t>::max());
+
+        http_header.SetMessageType(HTTP_RESPONSE);
+        http_header.SetVideoId(video_id);
+        http_header.SetResolution(resolution);
+        http_header.SetSegmentId(segment_id);
+
+        mpeg_header.SetFrameId(frames);
+        mpeg_header.SetPlaybackTime(timing.GetPlaybackTime(segment_id, 0));
+        mpeg_header.SetType(MPEG_SEGMENT_RESPONSE);
+        mpeg_header.SetSize(bytes - headers);
+
+        Ptr<Packet> response = Create<Packet>(&index[0], index.size());
+        response->AddAtEnd(Create<Packet>(bytes - headers - index.size()));
+        response->AddHeader(http_header);
+        response->AddHeader(mpeg_header);
+        return response;
+    }
+
+} // namespace ns3
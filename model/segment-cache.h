@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef SEGMENT_CACHE_H
+#define SEGMENT_CACHE_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/simple-ref-count.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "frame-trace.h"
+#include "video-timing.h"
+
+namespace ns3
+{
+
+    class UniformRandomVariable;
+
+    /**
+    * \ingroup dash
+    *
+    * \brief The MPEG frames of a single (video, resolution, segment) tuple.
+    *
+    * Each frame already carries its MPEGHeader and HTTPHeader. The packets are
+    * never modified once built, so senders hand out Copy()s of them, which only
+    * share the underlying buffers (copy-on-write).
+    */
+    class MpegSegment : public SimpleRefCount<MpegSegment>
+    {
+        public:
+            MpegSegment();
+
+            std::vector<Ptr<Packet> > frames;
+            uint32_t bytes;     // Size of all the frames, headers included
+    };
+
+    /**
+    * \ingroup dash
+    *
+    * \brief A server side cache of synthesized MPEG segments.
+    *
+    * Segments are keyed by (video_id, resolution, segment_id) and built once,
+    * no matter how many sockets request them. The least recently used
+    * segments are dropped when the total size exceeds MaxBytes; a MaxBytes of
+    * zero disables the cache, and every request builds a fresh segment.
+    *
+    * The frame sizes of a segment are drawn from a random stream of its
+    * own, numbered from its key, so a cached segment is identical to the one
+    * the uncached path would have built for the same seed and run number.
+    * The key must fit the stream number: video ids below 2^16, resolutions
+    * below 2^27 bps and segment ids below 2^19. When a
+    * FrameTrace is set, the sizes and types of the frames are read from it
+    * instead.
+    */
+    class SegmentCache : public Object
+    {
+        public:
+            static TypeId GetTypeId(void);
+            SegmentCache();
+
+            virtual ~SegmentCache();
+
+            /**
+            * \return the frames of the segment, building them on a miss.
+            */
+            Ptr<MpegSegment> GetSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id);
+
+            /**
+            * \brief Builds the frames of a segment, bypassing the cache, with
+            * the timing of its video.
+            */
+            Ptr<MpegSegment> CreateSegment(uint32_t video_id, uint32_t resolution, uint32_t segment_id) const;
+
+            /**
+            * \return the generator of the frame sizes of a segment, positioned
+            * at its first frame, or 0 if they are read from the frame trace.
+            */
+            Ptr<UniformRandomVariable> CreateFrameSizeGenerator(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+                const VideoTiming &timing) const;
+
+            /**
+            * \brief Builds the next frame of a segment, reading its size from
+            * the frame trace or drawing it from frame_size_gen.
+            */
+            Ptr<Packet> CreateFrame(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+                uint32_t frame_id, Ptr<UniformRandomVariable> frame_size_gen, const VideoTiming &timing) const;
+
+            /**
+            * \brief Builds the single response that carries a whole segment.
+            *
+            * Its MPEGHeader has the type MPEG_SEGMENT_RESPONSE, the number of
+            * frames as frame id, and the playback time of the first frame.
+            * The body starts with an index of MPEG_SEGMENT_INDEX_ENTRY bytes
+            * per frame, the type of the frame in the top byte and its size in
+            * the other three, in network order. The response is as long as the
+            * responses of the frames would have been, so the i-th frame is
+            * complete once the bytes of the first i + 1 frame responses have
+            * arrived.
+            */
+            Ptr<Packet> CreateSegmentResponse(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+                const VideoTiming &timing) const;
+
+            /**
+            * \return false if the cache is disabled (MaxBytes is zero).
+            */
+            bool IsEnabled(void) const;
+
+            uint64_t GetHits(void) const;      // Requests served from the cache
+            uint64_t GetMisses(void) const;    // Requests that built a new segment
+            uint64_t GetBytes(void) const;     // Bytes currently held by the cache
+
+        protected:
+            virtual void DoDispose(void);
+
+        private:
+            struct Key
+            {
+                uint32_t video_id;
+                uint32_t resolution;
+                uint32_t segment_id;
+
+                bool operator<(const Key &other) const;
+            };
+
+            typedef std::list<Key> LruList;
+
+            struct Entry
+            {
+                Ptr<MpegSegment> segment;
+                LruList::iterator lru;
+            };
+
+            void Evict(void);  // Drops segments until the cache fits in m_maxBytes
+
+            void DrawFrame(uint32_t resolution, uint32_t segment_id, uint32_t f_id,
+                Ptr<UniformRandomVariable> frame_size_gen, const VideoTiming &timing,
+                uint32_t &size, uint32_t &type) const;  // The size and type of a frame
+
+            void SetFrameTrace(std::string path);
+            std::string GetFrameTrace(void) const;
+
+            uint64_t m_maxBytes;
+            uint64_t m_bytes;
+            uint64_t m_hits;
+            uint64_t m_misses;
+
+            std::string m_tracePath;
+            Ptr<FrameTrace> m_trace;    // Shared with the caches that map the same file
+
+            std::map<Key, Entry> m_entries;
+            LruList m_lru;      // Most recently used first
+    };
+
+} // namespace ns3
+
+#endif /* SEGMENT_CACHE_H */
@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/random-variable-stream.h"
+#include "segment-cursor.h"
+#include "mpeg-header.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("SegmentCursor");
+
+    SegmentCursor::SegmentCursor() :
+        m_frameId(0) {
+    }
+
+    void SegmentCursor::Push(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+        Time deadline, bool wholeSegment, uint32_t firstFrame, uint32_t frameCount) {
+        NS_LOG_FUNCTION(this << video_id << resolution << segment_id << deadline << wholeSegment
+            << firstFrame << frameCount);
+        VideoTiming timing = VideoTiming::Get(video_id);
+        uint32_t frames = timing.GetFramesPerSegment();
+        if (wholeSegment) {
+            firstFrame = 0;
+            frameCount = 0;
+        }
+        uint32_t end = frameCount == 0 ? frames : std::min(firstFrame + frameCount, frames);
+        if (firstFrame >= end) {
+            NS_LOG_WARN("No frames to send in " << firstFrame << "+" << frameCount);
+            return;
+        }
+        Request request = { video_id, resolution, segment_id, deadline, timing, wholeSegment,
+            firstFrame, end };
+        m_requests.push_back(request);
+    }
+
+    uint32_t SegmentCursor::Cancel(uint32_t video_id, uint32_t segment_id) {
+        NS_LOG_FUNCTION(this << video_id << segment_id);
+        uint32_t cancelled = 0;
+        std::deque<Request>::iterator it = m_requests.begin();
+        while (it != m_requests.end()) {
+            if (it->video_id != video_id || it->segment_id != segment_id) {
+                ++it;
+                continue;
+            }
+            if (it == m_requests.begin()) {
+                if (it->wholeSegment && m_next) { // Partly sent
+                    ++it;
+                    continue;
+                }
+                m_frameId = 0;
+                m_segment = 0;
+                m_frameSizeGen = 0;
+                m_next = 0;
+            }
+            it = m_requests.erase(it);
+            cancelled++;
+        }
+        return cancelled;
+    }
+
+    bool SegmentCursor::IsEmpty(void) const {
+        return m_requests.empty();
+    }
+
+    uint32_t SegmentCursor::GetPending(void) const {
+        return m_requests.size();
+    }
+
+    uint32_t SegmentCursor::GetResolution(void) const {
+        return m_requests.empty() ? 0 : m_requests.front().resolution;
+    }
+
+    uint32_t SegmentCursor::GetVideoId(void) const {
+        return m_requests.empty() ? 0 : m_requests.front().video_id;
+    }
+
+    Time SegmentCursor::GetDeadline(void) const {
+        return m_requests.empty() ? Time::Max() : m_requests.front().deadline;
+    }
+
+    bool SegmentCursor::IsWholeSegment(void) const {
+        return !m_requests.empty() && m_requests.front().wholeSegment;
+    }
+
+    Ptr<Packet> SegmentCursor::Peek(Ptr<SegmentCache> cache) {
+        NS_LOG_FUNCTION(this);
+        NS_ASSERT(!m_requests.empty());
+
+        if (m_next) {
+            return m_next;
+        }
+
+        const Request &request = m_requests.front();
+
+        if (request.wholeSegment) {
+            m_next = cache->CreateSegmentResponse(request.video_id, request.resolution,
+                request.segment_id, request.timing);
+            return m_next;
+        }
+
+        if (m_frameId == 0) { // First frame of the request
+            if (cache->IsEnabled()) {
+                m_segment = cache->GetSegment(request.video_id, request.resolution, request.segment_id);
+            } else {
+                m_frameSizeGen = cache->CreateFrameSizeGenerator(request.video_id,
+                    request.resolution, request.segment_id, request.timing);
+                // The frame sizes are drawn in order, so skip the ones before the range
+                for (uint32_t f_id = 0; m_frameSizeGen && f_id < request.first; f_id++) {
+                    m_frameSizeGen->GetValue();
+                }
+            }
+        }
+
+        uint32_t f_id = request.first + m_frameId;
+        if (m_segment) {
+            m_next = m_segment->frames[f_id]->Copy();
+        } else {
+            m_next = cache->CreateFrame(request.video_id, request.resolution,
+                request.segment_id, f_id, m_frameSizeGen, request.timing);
+        }
+        return m_next;
+    }
+
+    void SegmentCursor::Pop(void) {
+        NS_LOG_FUNCTION(this);
+        NS_ASSERT(m_next);
+
+        m_next = 0;
+        if (m_requests.front().wholeSegment) {
+            m_requests.pop_front();
+        } else if (++m_frameId == m_requests.front().end - m_requests.front().first) {
+            m_requests.pop_front();
+            m_frameId = 0;
+            m_segment = 0;
+            m_frameSizeGen = 0;
+        }
+    }
+
+    void SegmentCursor::Pop(uint32_t bytes) {
+        NS_LOG_FUNCTION(this << bytes);
+        NS_ASSERT(m_next && IsWholeSegment() && bytes <= m_next->GetSize());
+
+        if (bytes == m_next->GetSize()) {
+            Pop();
+        } else {
+            m_next = m_next->CreateFragment(bytes, m_next->GetSize() - bytes);
+        }
+    }
+
+} // namespace ns3
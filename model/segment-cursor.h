@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef SEGMENT_CURSOR_H
+#define SEGMENT_CURSOR_H
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+
+#include <deque>
+
+#include "segment-cache.h"
+
+namespace ns3
+{
+
+    class UniformRandomVariable;
+
+    /**
+    * \ingroup dash
+    *
+    * \brief The send state of a connection: the segments it requested and the
+    * position of the next frame to send.
+    *
+    * Frames are made one at a time, when the socket has room for them, so the
+    * state of a connection does not grow with the size of the segments it
+    * requested. When the segment cache is enabled the frames are taken from
+    * the cached segment, otherwise they are generated from the segment's own
+    * frame size stream, which yields the same frames.
+    */
+    class SegmentCursor
+    {
+        public:
+            SegmentCursor();
+
+            /**
+            * \brief Appends a requested segment to the ones of the connection.
+            *
+            * \param deadline the time when the client will play the segment,
+            * or Time::Max () if it did not say.
+            * \param wholeSegment true to send the segment as a single response,
+            * see SegmentCache::CreateSegmentResponse.
+            * \param firstFrame, frameCount the frames to send, zero for all
+            * the frames from the first one. A whole segment response carries
+            * every frame.
+            */
+            void Push(uint32_t video_id, uint32_t resolution, uint32_t segment_id,
+                Time deadline = Time::Max(), bool wholeSegment = false,
+                uint32_t firstFrame = 0, uint32_t frameCount = 0);
+
+            /**
+            * \brief Drops the frames of the segment that have not been
+            * started. A whole segment response that is being sent is
+            * finished, as the client could not read it otherwise.
+            *
+            * \return the number of requests that were cut short or removed.
+            */
+            uint32_t Cancel(uint32_t video_id, uint32_t segment_id);
+
+            /**
+            * \return true if all the requested frames have been sent.
+            */
+            bool IsEmpty(void) const;
+
+            /**
+            * \return the next frame to send, making it if needed, or what is
+            * left to send of a whole segment response. The packet stays the
+            * next one until Pop () is called.
+            */
+            Ptr<Packet> Peek(Ptr<SegmentCache> cache);
+
+            /**
+            * \brief Moves on to the frame after the one returned by Peek ().
+            */
+            void Pop(void);
+
+            /**
+            * \brief Moves past the first bytes of a whole segment response,
+            * which may be sent in as many parts as needed.
+            */
+            void Pop(uint32_t bytes);
+
+            /**
+            * \return true if the segment being sent is a whole segment response.
+            */
+            bool IsWholeSegment(void) const;
+
+            /**
+            * \return the number of requested segments that are not fully sent.
+            */
+            uint32_t GetPending(void) const;
+
+            /**
+            * \return the resolution of the segment that is being sent.
+            */
+            uint32_t GetResolution(void) const;
+
+            /**
+            * \return the video id of the segment that is being sent.
+            */
+            uint32_t GetVideoId(void) const;
+
+            /**
+            * \return the deadline of the segment that is being sent.
+            */
+            Time GetDeadline(void) const;
+
+        private:
+            struct Request
+            {
+                uint32_t video_id;
+                uint32_t resolution;
+                uint32_t segment_id;
+                Time deadline;
+                VideoTiming timing;
+                bool wholeSegment;  // Sent as a single response
+                uint32_t first;     // The frames to send, first to end - 1
+                uint32_t end;
+            };
+
+            std::deque<Request> m_requests;     // The front one is being sent
+            uint32_t m_frameId;                 // The frames of the front request already sent
+            Ptr<MpegSegment> m_segment;         // The cached frames of the front request
+            Ptr<UniformRandomVariable> m_frameSizeGen; // Or the generator of its frame sizes
+            Ptr<Packet> m_next;                 // The next frame, or the rest of the response, once made
+    };
+
+} // namespace ns3
+
+#endif /* SEGMENT_CURSOR_H */
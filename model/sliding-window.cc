@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "sliding-window.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("SlidingWindow");
+
+    static const uint32_t SLIDING_WINDOW_SAMPLES = 16;  // Slots of a new ring
+
+    SlidingWindow::SlidingWindow() :
+        m_head(0), m_count(0), m_sum(0), m_inverseSum(0), m_nonPositive(0), m_decreases(0),
+        m_added(0) {
+    }
+
+    const SlidingWindow::Sample& SlidingWindow::At(uint32_t index) const {
+        return m_samples[(m_head + index) % m_samples.size()];
+    }
+
+    double SlidingWindow::GetValueOf(uint64_t seq) const {
+        return At(seq - (m_added - m_count)).value;
+    }
+
+    void SlidingWindow::Add(Time time, double value) {
+        NS_LOG_FUNCTION(this << time << value);
+        NS_ASSERT(m_count == 0 || time >= GetTime());
+
+        if (m_count > 0 && time == GetTime()) {
+            // Replaced in place, the last sample is not in m_min
+            Sample &last = m_samples[(m_head + m_count - 1) % m_samples.size()];
+            if (m_count > 1 && last.value < GetValue(1)) {
+                m_decreases--;
+            }
+            if (m_count > 1 && value < GetValue(1)) {
+                m_decreases++;
+            }
+            m_sum += value - last.value;
+            if (last.value > 0) {
+                m_inverseSum -= 1 / last.value;
+            } else {
+                m_nonPositive--;
+            }
+            if (value > 0) {
+                m_inverseSum += 1 / value;
+            } else {
+                m_nonPositive++;
+            }
+            last.value = value;
+            return;
+        }
+
+        if (m_count > 0) {
+            Settle();
+        }
+
+        if (m_count == m_samples.size()) {
+            // Unroll the ring into one twice its size
+            std::vector<Sample> samples(std::max<size_t>(2 * m_samples.size(), SLIDING_WINDOW_SAMPLES));
+            for (uint32_t i = 0; i < m_count; i++) {
+                samples[i] = At(i);
+            }
+            m_samples.swap(samples);
+            m_head = 0;
+        }
+
+        if (m_count > 0 && value < GetValue()) {
+            m_decreases++;
+        }
+        Sample &sample = m_samples[(m_head + m_count) % m_samples.size()];
+        sample.time = time;
+        sample.value = value;
+        m_count++;
+        m_added++;
+
+        m_sum += value;
+        if (value > 0) {
+            m_inverseSum += 1 / value;
+        } else {
+            m_nonPositive++;
+        }
+    }
+
+    void SlidingWindow::Settle(void) {
+        double value = GetValue();
+        while (!m_min.empty() && GetValueOf(m_min.back()) >= value) {
+            m_min.pop_back();
+        }
+        m_min.push_back(m_added - 1);
+    }
+
+    void SlidingWindow::Expire(Time limit) {
+        NS_LOG_FUNCTION(this << limit);
+
+        while (m_count > 0 && At(0).time < limit) {
+            double value = At(0).value;
+            if (m_count > 1 && At(1).value < value) {
+                m_decreases--;
+            }
+            m_sum -= value;
+            if (value > 0) {
+                m_inverseSum -= 1 / value;
+            } else {
+                m_nonPositive--;
+            }
+            if (!m_min.empty() && m_min.front() == m_added - m_count) {
+                m_min.pop_front();
+            }
+            m_head = (m_head + 1) % m_samples.size();
+            m_count--;
+        }
+        if (m_count == 0) {
+            Clear();    // Drops the rounding errors of the running sums
+        }
+    }
+
+    void SlidingWindow::Clear(void) {
+        m_head = 0;
+        m_count = 0;
+        m_sum = 0;
+        m_inverseSum = 0;
+        m_nonPositive = 0;
+        m_decreases = 0;
+        m_min.clear();
+    }
+
+    bool SlidingWindow::IsEmpty(void) const {
+        return m_count == 0;
+    }
+
+    uint32_t SlidingWindow::GetCount(void) const {
+        return m_count;
+    }
+
+    double SlidingWindow::GetMean(void) const {
+        return m_count > 0 ? m_sum / m_count : 0;
+    }
+
+    double SlidingWindow::GetHarmonicMean(void) const {
+        return m_count > 0 && m_nonPositive == 0 ? m_count / m_inverseSum : 0;
+    }
+
+    double SlidingWindow::GetMin(void) const {
+        if (m_count == 0) {
+            return 0;
+        }
+        return m_min.empty() ? GetValue() : std::min(GetValueOf(m_min.front()), GetValue());
+    }
+
+    bool SlidingWindow::IsNonDecreasing(void) const {
+        return m_decreases == 0;
+    }
+
+    double SlidingWindow::GetValue(uint32_t age) const {
+        NS_ASSERT(age < m_count);
+        return At(m_count - 1 - age).value;
+    }
+
+    Time SlidingWindow::GetTime(uint32_t age) const {
+        NS_ASSERT(age < m_count);
+        return At(m_count - 1 - age).time;
+    }
+
+} // namespace ns3
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef SLIDING_WINDOW_H
+#define SLIDING_WINDOW_H
+
+#include "ns3/nstime.h"
+
+#include <deque>
+#include <vector>
+
+namespace ns3
+{
+
+    /**
+    * \ingroup dash
+    *
+    * \brief The samples of a measure over a sliding time window, with the
+    * statistics the adaptation algorithms use.
+    *
+    * The samples are kept in a ring, in the order they were taken, with
+    * running sums for the mean and harmonic mean, and a monotonic queue of
+    * the candidate minimums, so adding or expiring a sample and reading any
+    * statistic take O(1) (amortized) time.
+    */
+    class SlidingWindow
+    {
+        public:
+            SlidingWindow();
+
+            /**
+            * \brief Adds a sample. A sample taken at the same time as the
+            * last one replaces it.
+            *
+            * \param time when the sample was taken, no earlier than the last one
+            */
+            void Add(Time time, double value);
+
+            /**
+            * \brief Drops the samples taken before the given time.
+            */
+            void Expire(Time limit);
+
+            void Clear(void);
+
+            bool IsEmpty(void) const;
+            uint32_t GetCount(void) const;
+
+            /**
+            * \return the mean of the samples, or 0 without samples.
+            */
+            double GetMean(void) const;
+
+            /**
+            * \return the harmonic mean of the samples, or 0 without samples
+            * or with a sample that is not positive.
+            */
+            double GetHarmonicMean(void) const;
+
+            /**
+            * \return the smallest sample, or 0 without samples.
+            */
+            double GetMin(void) const;
+
+            /**
+            * \return true if no sample is smaller than the one before it.
+            */
+            bool IsNonDecreasing(void) const;
+
+            /**
+            * \param age 0 for the last sample, 1 for the one before it, etc.
+            */
+            double GetValue(uint32_t age = 0) const;
+            Time GetTime(uint32_t age = 0) const;
+
+        private:
+            struct Sample
+            {
+                Time time;
+                double value;
+            };
+
+            const Sample& At(uint32_t index) const;    // The index-th sample, from the oldest one
+            double GetValueOf(uint64_t seq) const;     // Of a sample, by its sequence number
+            void Settle(void);      // Moves the last sample into m_min, before a later one
+
+            std::vector<Sample> m_samples; // A ring of samples, doubled when full
+            uint32_t m_head;               // Index of the oldest sample
+            uint32_t m_count;
+
+            double m_sum;
+            double m_inverseSum;           // Of the positive samples
+            uint32_t m_nonPositive;        // Samples left out of m_inverseSum
+            uint32_t m_decreases;          // Samples smaller than the one before them
+
+            uint64_t m_added;              // Samples added so far, which numbers them
+
+            // The sequence numbers of the samples before the last one that are
+            // smaller than all the later ones, by increasing value. The last
+            // sample stays out of it until a later one comes, so that the one
+            // taken at the same time can replace it in place.
+            std::deque<uint64_t> m_min;
+    };
+
+} // namespace ns3
+
+#endif /* SLIDING_WINDOW_H */
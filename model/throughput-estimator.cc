@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "throughput-estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("ThroughputEstimator");
+
+    NS_OBJECT_ENSURE_REGISTERED(ThroughputEstimator);
+    NS_OBJECT_ENSURE_REGISTERED(MeanThroughputEstimator);
+    NS_OBJECT_ENSURE_REGISTERED(HarmonicMeanThroughputEstimator);
+    NS_OBJECT_ENSURE_REGISTERED(EwmaThroughputEstimator);
+    NS_OBJECT_ENSURE_REGISTERED(LastSampleThroughputEstimator);
+    NS_OBJECT_ENSURE_REGISTERED(PercentileThroughputEstimator);
+
+    TypeId ThroughputEstimator::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::ThroughputEstimator").SetParent<Object>();
+        return tid;
+    }
+
+    TypeId MeanThroughputEstimator::GetTypeId(void) {
+        static TypeId tid =
+        TypeId("ns3::MeanThroughputEstimator").SetParent<ThroughputEstimator>()
+            .AddConstructor<MeanThroughputEstimator>()
+            .AddAttribute("Window", "The samples taken within this time are averaged.",
+            TimeValue(Seconds(10)), MakeTimeAccessor(&MeanThroughputEstimator::m_window),
+            MakeTimeChecker());
+        return tid;
+    }
+
+    MeanThroughputEstimator::MeanThroughputEstimator() :
+        m_window(Seconds(10)) {
+    }
+
+    void MeanThroughputEstimator::AddSample(Time time, double bitrate) {
+        m_samples.Add(time, bitrate);
+        m_samples.Expire(time - m_window);
+    }
+
+    double MeanThroughputEstimator::GetEstimate(void) const {
+        return m_samples.GetMean();
+    }
+
+    TypeId HarmonicMeanThroughputEstimator::GetTypeId(void) {
+        static TypeId tid =
+        TypeId("ns3::HarmonicMeanThroughputEstimator").SetParent<ThroughputEstimator>()
+            .AddConstructor<HarmonicMeanThroughputEstimator>()
+            .AddAttribute("Window", "The samples taken within this time are averaged.",
+            TimeValue(Seconds(10)), MakeTimeAccessor(&HarmonicMeanThroughputEstimator::m_window),
+            MakeTimeChecker());
+        return tid;
+    }
+
+    HarmonicMeanThroughputEstimator::HarmonicMeanThroughputEstimator() :
+        m_window(Seconds(10)) {
+    }
+
+    void HarmonicMeanThroughputEstimator::AddSample(Time time, double bitrate) {
+        m_samples.Add(time, bitrate);
+        m_samples.Expire(time - m_window);
+    }
+
+    double HarmonicMeanThroughputEstimator::GetEstimate(void) const {
+        return m_samples.GetHarmonicMean();
+    }
+
+    TypeId EwmaThroughputEstimator::GetTypeId(void) {
+        static TypeId tid =
+        TypeId("ns3::EwmaThroughputEstimator").SetParent<ThroughputEstimator>()
+            .AddConstructor<EwmaThroughputEstimator>()
+            .AddAttribute("FastHalfLife", "The half-life of the fast moving average.",
+            TimeValue(Seconds(3)), MakeTimeAccessor(&EwmaThroughputEstimator::m_fastHalfLife),
+            MakeTimeChecker())
+            .AddAttribute("SlowHalfLife", "The half-life of the slow moving average.",
+            TimeValue(Seconds(9)), MakeTimeAccessor(&EwmaThroughputEstimator::m_slowHalfLife),
+            MakeTimeChecker());
+        return tid;
+    }
+
+    EwmaThroughputEstimator::EwmaThroughputEstimator() :
+        m_fastHalfLife(Seconds(3)), m_slowHalfLife(Seconds(9)), m_started(false), m_fast(0),
+        m_slow(0) {
+    }
+
+    void EwmaThroughputEstimator::AddSample(Time time, double bitrate) {
+        if (!m_started) {
+            m_fast = m_slow = bitrate;
+            m_started = true;
+        } else {
+            double dt = (time - m_last).GetSeconds();
+            double fast = std::pow(0.5, dt / m_fastHalfLife.GetSeconds());
+            double slow = std::pow(0.5, dt / m_slowHalfLife.GetSeconds());
+            m_fast = fast * m_fast + (1 - fast) * bitrate;
+            m_slow = slow * m_slow + (1 - slow) * bitrate;
+        }
+        m_last = time;
+    }
+
+    double EwmaThroughputEstimator::GetEstimate(void) const {
+        return std::min(m_fast, m_slow);
+    }
+
+    TypeId LastSampleThroughputEstimator::GetTypeId(void) {
+        static TypeId tid =
+        TypeId("ns3::LastSampleThroughputEstimator").SetParent<ThroughputEstimator>()
+            .AddConstructor<LastSampleThroughputEstimator>();
+        return tid;
+    }
+
+    LastSampleThroughputEstimator::LastSampleThroughputEstimator() :
+        m_last(0) {
+    }
+
+    void LastSampleThroughputEstimator::AddSample(Time time, double bitrate) {
+        m_last = bitrate;
+    }
+
+    double LastSampleThroughputEstimator::GetEstimate(void) const {
+        return m_last;
+    }
+
+    TypeId PercentileThroughputEstimator::GetTypeId(void) {
+        static TypeId tid =
+        TypeId("ns3::PercentileThroughputEstimator").SetParent<ThroughputEstimator>()
+            .AddConstructor<PercentileThroughputEstimator>()
+            .AddAttribute("Samples", "The number of recent samples the percentile is taken from.",
+            UintegerValue(20), MakeUintegerAccessor(&PercentileThroughputEstimator::m_maxSamples),
+            MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("Percentile", "The percentile of the samples that is the estimate.",
+            DoubleValue(20), MakeDoubleAccessor(&PercentileThroughputEstimator::m_percentile),
+            MakeDoubleChecker<double>(0, 100));
+        return tid;
+    }
+
+    PercentileThroughputEstimator::PercentileThroughputEstimator() :
+        m_maxSamples(20), m_percentile(20), m_next(0) {
+    }
+
+    void PercentileThroughputEstimator::AddSample(Time time, double bitrate) {
+        if (m_ring.size() < m_maxSamples) {
+            m_ring.push_back(bitrate);
+        } else {
+            // Replace the oldest sample
+            double oldest = m_ring[m_next];
+            m_ring[m_next] = bitrate;
+            m_next = (m_next + 1) % m_ring.size();
+            m_sorted.erase(std::lower_bound(m_sorted.begin(), m_sorted.end(), oldest));
+        }
+        m_sorted.insert(std::upper_bound(m_sorted.begin(), m_sorted.end(), bitrate), bitrate);
+    }
+
+    double PercentileThroughputEstimator::GetEstimate(void) const {
+        if (m_sorted.empty()) {
+            return 0;
+        }
+        // The nearest rank
+        uint32_t rank = std::ceil(m_percentile / 100 * m_sorted.size());
+        return m_sorted[rank > 0 ? rank - 1 : 0];
+    }
+
+} // namespace ns3
@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef THROUGHPUT_ESTIMATOR_H
+#define THROUGHPUT_ESTIMATOR_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+
+#include "sliding-window.h"
+
+namespace ns3
+{
+
+    /**
+    * \ingroup dash
+    *
+    * \brief Estimates the throughput of a DashClient from the bitrates at
+    * which it fetched its segments.
+    *
+    * DashClient feeds a sample per segment, and the adaptation algorithms
+    * read the estimate as m_bitrateEstimate. Every estimator does a
+    * constant amount of work per sample, but the percentile one.
+    */
+    class ThroughputEstimator : public Object
+    {
+        public:
+            static TypeId GetTypeId(void);
+
+            /**
+            * \param time when the segment was fetched
+            * \param bitrate the bitrate it was fetched at, in bps
+            */
+            virtual void AddSample(Time time, double bitrate) = 0;
+
+            /**
+            * \return the estimated throughput in bps, 0 before any sample.
+            */
+            virtual double GetEstimate(void) const = 0;
+    };
+
+    /**
+    * \brief The arithmetic mean of the samples over the last Window.
+    */
+    class MeanThroughputEstimator : public ThroughputEstimator
+    {
+        public:
+            static TypeId GetTypeId(void);
+            MeanThroughputEstimator();
+
+            virtual void AddSample(Time time, double bitrate);
+            virtual double GetEstimate(void) const;
+
+        private:
+            Time m_window;
+            SlidingWindow m_samples;
+    };
+
+    /**
+    * \brief The harmonic mean of the samples over the last Window, which
+    * weighs down the bursts of high throughput.
+    */
+    class HarmonicMeanThroughputEstimator : public ThroughputEstimator
+    {
+        public:
+            static TypeId GetTypeId(void);
+            HarmonicMeanThroughputEstimator();
+
+            virtual void AddSample(Time time, double bitrate);
+            virtual double GetEstimate(void) const;
+
+        private:
+            Time m_window;
+            SlidingWindow m_samples;
+    };
+
+    /**
+    * \brief The lower of a fast and a slow exponentially weighted moving
+    * average, so drops are followed quickly and rises slowly.
+    *
+    * The weight of the past halves every half-life of time between samples.
+    */
+    class EwmaThroughputEstimator : public ThroughputEstimator
+    {
+        public:
+            static TypeId GetTypeId(void);
+            EwmaThroughputEstimator();
+
+            virtual void AddSample(Time time, double bitrate);
+            virtual double GetEstimate(void) const;
+
+        private:
+            Time m_fastHalfLife;
+            Time m_slowHalfLife;
+            bool m_started;
+            Time m_last;        // Time of the last sample
+            double m_fast;
+            double m_slow;
+    };
+
+    /**
+    * \brief The last sample.
+    */
+    class LastSampleThroughputEstimator : public ThroughputEstimator
+    {
+        public:
+            static TypeId GetTypeId(void);
+            LastSampleThroughputEstimator();
+
+            virtual void AddSample(Time time, double bitrate);
+            virtual double GetEstimate(void) const;
+
+        private:
+            double m_last;
+    };
+
+    /**
+    * \brief A low percentile of the last Samples samples, a conservative
+    * estimate for variable links.
+    *
+    * The samples are kept sorted as they come and go, so unlike the other
+    * estimators its work per sample grows with Samples, up to a shift of
+    * all of them.
+    */
+    class PercentileThroughputEstimator : public ThroughputEstimator
+    {
+        public:
+            static TypeId GetTypeId(void);
+            PercentileThroughputEstimator();
+
+            virtual void AddSample(Time time, double bitrate);
+            virtual double GetEstimate(void) const;
+
+        private:
+            uint32_t m_maxSamples;
+            double m_percentile;
+            std::vector<double> m_ring;     // The last samples, in arrival order
+            uint32_t m_next;                // Slot of the next sample, once the ring is full
+            std::vector<double> m_sorted;   // The same, by value
+    };
+
+} // namespace ns3
+
+#endif /* THROUGHPUT_ESTIMATOR_H */
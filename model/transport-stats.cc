@@ -0,0 +1,72 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "transport-stats.h"
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("TransportStats");
+
+    TransportStats::TransportStats() :
+        m_srtt(Seconds(0)), m_minRtt(Seconds(0)), m_rttSamples(0), m_cwnd(0), m_losses(0) {
+    }
+
+    void TransportStats::Reset(void) {
+        m_srtt = Seconds(0);
+        m_minRtt = Seconds(0);
+        m_rttSamples = 0;
+        m_cwnd = 0;
+        m_losses = 0;
+    }
+
+    void TransportStats::AddRtt(Time rtt) {
+        NS_LOG_FUNCTION(this << rtt);
+        if (rtt <= Seconds(0)) { // Not measured yet
+            return;
+        }
+        if (m_rttSamples++ == 0) {
+            m_srtt = rtt;
+            m_minRtt = rtt;
+        } else {
+            m_srtt = Seconds(0.875 * m_srtt.GetSeconds() + 0.125 * rtt.GetSeconds());
+            m_minRtt = Min(m_minRtt, rtt);
+        }
+    }
+
+    void TransportStats::SetCwnd(uint32_t bytes) {
+        m_cwnd = bytes;
+    }
+
+    void TransportStats::AddLoss(void) {
+        m_losses++;
+    }
+
+    bool TransportStats::HasData(void) const {
+        return m_rttSamples > 0 && m_cwnd > 0;
+    }
+
+    Time TransportStats::GetRtt(void) const {
+        return m_srtt;
+    }
+
+    Time TransportStats::GetMinRtt(void) const {
+        return m_minRtt;
+    }
+
+    uint32_t TransportStats::GetRttSamples(void) const {
+        return m_rttSamples;
+    }
+
+    uint32_t TransportStats::GetCwnd(void) const {
+        return m_cwnd;
+    }
+
+    uint32_t TransportStats::GetLosses(void) const {
+        return m_losses;
+    }
+
+    double TransportStats::GetBandwidthEstimate(void) const {
+        return HasData() ? 8.0 * m_cwnd / m_srtt.GetSeconds() : 0;
+    }
+
+} // namespace ns3
@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef TRANSPORT_STATS_H
+#define TRANSPORT_STATS_H
+
+#include "ns3/nstime.h"
+
+namespace ns3
+{
+
+    /**
+    * \ingroup dash
+    *
+    * \brief Running statistics of the TCP state of a connection, as its
+    * congestion window, round trip and loss events, fed by the traces of
+    * its socket.
+    *
+    * The window over the smoothed round trip is the rate the connection
+    * would send at with data to send, which is known before a segment has
+    * been received on it.
+    */
+    class TransportStats
+    {
+        public:
+            TransportStats();
+
+            void Reset(void);   // For a new connection
+
+            /**
+            * \brief Adds a round trip measurement, smoothed as TCP does, with
+            * a weight of 1/8 for the new one.
+            */
+            void AddRtt(Time rtt);
+            void SetCwnd(uint32_t bytes);
+            void AddLoss(void);     // A fast recovery or a timeout
+
+            /**
+            * \return true once both the round trip and the window are known.
+            */
+            bool HasData(void) const;
+
+            Time GetRtt(void) const;        // Smoothed, zero if unknown
+            Time GetMinRtt(void) const;     // Zero if unknown
+            uint32_t GetRttSamples(void) const;
+            uint32_t GetCwnd(void) const;   // Bytes
+            uint32_t GetLosses(void) const;
+
+            /**
+            * \return the bits per second of a window per smoothed round
+            * trip, or 0 if either is unknown.
+            */
+            double GetBandwidthEstimate(void) const;
+
+        private:
+            Time m_srtt;
+            Time m_minRtt;
+            uint32_t m_rttSamples;
+            uint32_t m_cwnd;
+            uint32_t m_losses;
+    };
+
+} // namespace ns3
+
+#endif /* TRANSPORT_STATS_H */
@@ -0,0 +1,76 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "video-timing.h"
+#include "mpeg-header.h"
+#include "mpd-file-handler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+    NS_LOG_COMPONENT_DEFINE("VideoTiming");
+
+    std::map<uint32_t, VideoTiming> VideoTiming::s_timings;
+
+    VideoTiming::VideoTiming() :
+        m_framesPerSegment(MPEG_FRAMES_PER_SEGMENT), m_frameInterval(MilliSeconds(MPEG_TIME_BETWEEN_FRAMES)) {
+    }
+
+    VideoTiming::VideoTiming(uint32_t framesPerSegment, Time frameInterval) :
+        m_framesPerSegment(framesPerSegment), m_frameInterval(frameInterval) {
+        if (framesPerSegment == 0 || !frameInterval.IsStrictlyPositive()) {
+            NS_FATAL_ERROR("A segment needs frames, and frames a positive interval");
+        }
+    }
+
+    VideoTiming VideoTiming::Get(uint32_t video_id) {
+        std::map<uint32_t, VideoTiming>::const_iterator it = s_timings.find(video_id);
+        if (it != s_timings.end()) {
+            return it->second;
+        }
+
+        VideoTiming timing;
+        Ptr<const MpdManifest> manifest = MpdFileHandler::getInstance()->Get(video_id);
+        if (manifest) {
+            if (manifest->GetFrameRate() > 0) {
+                timing.m_frameInterval = Seconds(1 / manifest->GetFrameRate());
+            }
+            Time segment = manifest->GetSegmentDuration();
+            if (segment.IsStrictlyPositive()) {
+                timing.m_framesPerSegment = std::max(1.0,
+                    std::floor(segment.GetSeconds() / timing.m_frameInterval.GetSeconds() + 0.5));
+            }
+        }
+        return timing;
+    }
+
+    void VideoTiming::Set(uint32_t video_id, const VideoTiming &timing) {
+        NS_LOG_FUNCTION(video_id << timing.m_framesPerSegment << timing.m_frameInterval);
+        s_timings[video_id] = timing;
+    }
+
+    void VideoTiming::Clear(uint32_t video_id) {
+        s_timings.erase(video_id);
+    }
+
+    uint32_t VideoTiming::GetFramesPerSegment(void) const {
+        return m_framesPerSegment;
+    }
+
+    Time VideoTiming::GetFrameInterval(void) const {
+        return m_frameInterval;
+    }
+
+    Time VideoTiming::GetSegmentDuration(void) const {
+        return TimeStep(m_frameInterval.GetTimeStep() * (int64_t) m_framesPerSegment);
+    }
+
+    Time VideoTiming::GetPlaybackTime(uint32_t segment_id, uint32_t frame_id) const {
+        return TimeStep(m_frameInterval.GetTimeStep()
+            * ((int64_t) segment_id * m_framesPerSegment + frame_id));
+    }
+
+} // namespace ns3
@@ -0,0 +1,66 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef VIDEO_TIMING_H
+#define VIDEO_TIMING_H
+
+#include "ns3/nstime.h"
+
+#include <map>
+
+namespace ns3
+{
+
+    /**
+    * \ingroup dash
+    *
+    * \brief The frame rate and segment length of a video, which the servers
+    * make the frames with, the players play them at and the adaptation
+    * algorithms reason with.
+    *
+    * The timing of a video is the one set for it, or else the one of its
+    * manifest (see MpdFileHandler::Assign), or else MPEG_FRAMES_PER_SEGMENT
+    * frames MPEG_TIME_BETWEEN_FRAMES ms apart. A manifest whose segment
+    * timeline varies gives the length of its first segment.
+    */
+    class VideoTiming
+    {
+        public:
+            VideoTiming();
+            VideoTiming(uint32_t framesPerSegment, Time frameInterval);
+
+            /**
+            * \return the timing of the video. Meant to be called once per
+            * client or request, not per frame.
+            */
+            static VideoTiming Get(uint32_t video_id);
+
+            /**
+            * \brief Sets the timing of a video, for the clients and servers
+            * that start after the call.
+            */
+            static void Set(uint32_t video_id, const VideoTiming &timing);
+
+            /**
+            * \brief Restores the timing of its manifest, or the default one.
+            */
+            static void Clear(uint32_t video_id);
+
+            uint32_t GetFramesPerSegment(void) const;
+            Time GetFrameInterval(void) const;
+            Time GetSegmentDuration(void) const;
+
+            /**
+            * \return the position of a frame in the video.
+            */
+            Time GetPlaybackTime(uint32_t segment_id, uint32_t frame_id) const;
+
+        private:
+            uint32_t m_framesPerSegment;
+            Time m_frameInterval;
+
+            static std::map<uint32_t, VideoTiming> s_timings;   // Keyed by video id
+    };
+
+} // namespace ns3
+
+#endif /* VIDEO_TIMING_H */
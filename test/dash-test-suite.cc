@@ -7,7 +7,12 @@
 #include "ns3/test.h"
 
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <utility>
 #include <fstream>
+#include <sstream>
+#include <map>
 #include "ns3/core-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/internet-module.h"
@@ -142,6 +147,2046 @@ DashTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Checks that the segment cache builds the same frames as the uncached path,
+// and that it keeps within its byte budget.
+class SegmentCacheTestCase : public TestCase
+{
+public:
+  SegmentCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SegmentCacheTestCase::SegmentCacheTestCase ()
+  : TestCase ("Cached segments match the uncached ones")
+{
+}
+
+void
+SegmentCacheTestCase::DoRun (void)
+{
+  Ptr<SegmentCache> cache = CreateObject<SegmentCache> ();
+  Ptr<MpegSegment> cached = cache->GetSegment (1, 334000, 7);
+  Ptr<MpegSegment> hit = cache->GetSegment (1, 334000, 7);
+  Ptr<MpegSegment> uncached = cache->CreateSegment (1, 334000, 7);
+
+  NS_TEST_ASSERT_MSG_EQ (cached, hit, "A hit should return the cached frames");
+  NS_TEST_ASSERT_MSG_EQ (cache->GetHits (), 1, "Wrong number of hits");
+  NS_TEST_ASSERT_MSG_EQ (cache->GetMisses (), 1, "Wrong number of misses");
+  NS_TEST_ASSERT_MSG_EQ (cache->GetBytes (), cached->bytes, "Wrong cache size");
+
+  NS_TEST_ASSERT_MSG_EQ (cached->frames.size (), uncached->frames.size (), "Different number of frames");
+  for (uint32_t f_id = 0; f_id < cached->frames.size (); f_id++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (cached->frames[f_id]->GetSize (), uncached->frames[f_id]->GetSize (),
+                             "Frame " << f_id << " differs from the uncached one");
+    }
+
+  // Room for one segment only, so the least recently used one is dropped
+  Ptr<SegmentCache> small = CreateObject<SegmentCache> ();
+  small->SetAttribute ("MaxBytes", UintegerValue (cached->bytes * 3 / 2));
+  small->GetSegment (1, 334000, 7);
+  small->GetSegment (1, 334000, 8);
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (small->GetBytes (), cached->bytes * 3 / 2, "The cache exceeded its budget");
+  small->GetSegment (1, 334000, 7);
+  NS_TEST_ASSERT_MSG_EQ (small->GetMisses (), 3, "The evicted segment should have been rebuilt");
+
+  Ptr<SegmentCache> disabled = CreateObject<SegmentCache> ();
+  disabled->SetAttribute ("MaxBytes", UintegerValue (0));
+  disabled->GetSegment (1, 334000, 7);
+  disabled->GetSegment (1, 334000, 7);
+  NS_TEST_ASSERT_MSG_EQ (disabled->GetHits (), 0, "A disabled cache should not hit");
+  NS_TEST_ASSERT_MSG_EQ (disabled->GetBytes (), 0, "A disabled cache should not hold segments");
+
+  // Without a cache the cursor makes the frames one at a time
+  SegmentCursor cursor;
+  cursor.Push (1, 334000, 7);
+  for (uint32_t f_id = 0; f_id < cached->frames.size (); f_id++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (cursor.Peek (disabled)->GetSize (), cached->frames[f_id]->GetSize (),
+                             "Generated frame " << f_id << " differs from the cached one");
+      cursor.Pop ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (cursor.IsEmpty (), true, "The segment should have been sent");
+}
+
+// Checks that the frames of a converted trace are served by the segment cache.
+class FrameTraceTestCase : public TestCase
+{
+public:
+  FrameTraceTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FrameTraceTestCase::FrameTraceTestCase ()
+  : TestCase ("Frame sizes and types are read from a frame trace")
+{
+}
+
+void
+FrameTraceTestCase::DoRun (void)
+{
+  std::string textPath = CreateTempDirFilename ("frames.txt");
+  std::string binaryPath = CreateTempDirFilename ("frames.bin");
+
+  std::ofstream text (textPath.c_str ());
+  text << "# bitrate type size" << std::endl
+       << "1000000 I 9000" << std::endl
+       << "45000 I 900" << std::endl
+       << "1000000 P 3000" << std::endl
+       << std::endl
+       << "45000 P 300" << std::endl;
+  text.close ();
+
+  NS_TEST_ASSERT_MSG_EQ (FrameTrace::Convert (textPath, binaryPath), true, "Could not convert the trace");
+
+  Ptr<FrameTrace> trace = FrameTrace::Open (binaryPath);
+  NS_TEST_ASSERT_MSG_EQ (trace, FrameTrace::Open (binaryPath), "The trace should be mapped once");
+  NS_TEST_ASSERT_MSG_EQ (trace->GetRepresentations (), 2, "Wrong number of representations");
+  NS_TEST_ASSERT_MSG_EQ (trace->GetBitrate (0), 45000, "The representations should be sorted");
+  NS_TEST_ASSERT_MSG_EQ (trace->GetFrames (1000000), 2, "Wrong number of frames");
+
+  uint32_t size, type;
+  trace->GetFrame (500000, 3, size, type);
+  NS_TEST_ASSERT_MSG_EQ (size, 300, "Should fall back to the lower bitrate, and wrap around");
+  NS_TEST_ASSERT_MSG_EQ (type, 'P', "Wrong frame type");
+
+  Ptr<SegmentCache> cache = CreateObject<SegmentCache> ();
+  cache->SetAttribute ("FrameTrace", StringValue (binaryPath));
+  Ptr<MpegSegment> segment = cache->GetSegment (1, 1000000, 0);
+  for (uint32_t f_id = 0; f_id < 2; f_id++)
+    {
+      MPEGHeader mpeg_header;
+      segment->frames[f_id]->PeekHeader (mpeg_header);
+      NS_TEST_ASSERT_MSG_EQ (mpeg_header.GetSize (), f_id == 0 ? 9000 : 3000, "Wrong frame size");
+      NS_TEST_ASSERT_MSG_EQ (mpeg_header.GetType (), f_id == 0 ? 'I' : 'P', "Wrong frame type");
+    }
+}
+
+// Checks that messages are popped across reads, copying only to join them.
+class PacketRingTestCase : public TestCase
+{
+public:
+  PacketRingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PacketRingTestCase::PacketRingTestCase ()
+  : TestCase ("Messages are popped across the reads they arrived in")
+{
+}
+
+void
+PacketRingTestCase::DoRun (void)
+{
+  uint8_t data[100];
+  for (uint32_t i = 0; i < sizeof (data); i++)
+    {
+      data[i] = i;
+    }
+
+  // More reads than the initial slots, so the ring grows while it wraps
+  PacketRing ring;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      ring.Push (Create<Packet> (&data[10 * i], 10));
+      if (i == 4)
+        {
+          ring.Drop (15);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (ring.GetSize (), 85, "Wrong ring size");
+
+  Ptr<Packet> inside = ring.Pop (5);
+  NS_TEST_ASSERT_MSG_EQ (ring.GetBytesCopied (), 0, "A message inside one read was copied");
+
+  Ptr<Packet> across = ring.Pop (30);
+  NS_TEST_ASSERT_MSG_EQ (ring.GetBytesCopied (), 20, "Only the joined fragments should be copied");
+
+  uint8_t out[30];
+  inside->CopyData (out, 5);
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) out[0], 15, "Wrong first byte");
+  across->CopyData (out, 30);
+  for (uint32_t i = 0; i < 30; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) out[i], 20 + i, "Wrong byte " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (ring.GetSize (), 50, "Wrong ring size");
+
+  NS_TEST_ASSERT_MSG_EQ (ring.GetCapacity (), 16, "The ring should have doubled twice");
+
+  // An emptied ring gives its slots back, and the next one reuses them
+  uint64_t pooled = PacketRing::GetPooledSlots ();
+  ring.Drop (ring.GetSize ());
+  NS_TEST_ASSERT_MSG_EQ (ring.GetCapacity (), 0, "An empty ring should hold no slots");
+  NS_TEST_ASSERT_MSG_EQ (PacketRing::GetPooledSlots (), pooled + 16, "The slots were not pooled");
+
+  // Messages are no longer capped by the size of a parser buffer
+  PacketRing large;
+  large.Push (Create<Packet> (150000));
+  large.Push (Create<Packet> (150000));
+  NS_TEST_ASSERT_MSG_EQ (large.Pop (250000)->GetSize (), 250000, "Wrong size of a large message");
+
+  large.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (large.GetSize (), 0, "The ring was not cleared");
+  NS_TEST_ASSERT_MSG_EQ (large.GetCapacity (), 0, "A cleared ring should hold no slots");
+}
+
+// Checks that requests are decoded whether TCP splits or coalesces them.
+class HttpRequestParserTestCase : public TestCase
+{
+public:
+  HttpRequestParserTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+HttpRequestParserTestCase::HttpRequestParserTestCase ()
+  : TestCase ("Split and coalesced requests are decoded")
+{
+}
+
+void
+HttpRequestParserTestCase::DoRun (void)
+{
+  // Three pipelined requests, in a single stream
+  Ptr<Packet> stream = Create<Packet> ();
+  for (uint32_t segment_id = 0; segment_id < 3; segment_id++)
+    {
+      HTTPRequestHeader requestHeader;
+      requestHeader.SetDeadline (Seconds (segment_id + 1));
+      Ptr<Packet> request = Create<Packet> (HTTP_REQUEST_BODY - requestHeader.GetSerializedSize ());
+      request->AddHeader (requestHeader);
+
+      HTTPHeader header;
+      header.SetMessageType (HTTP_REQUEST);
+      header.SetVideoId (1);
+      header.SetResolution (45000);
+      header.SetSegmentId (segment_id);
+      request->AddHeader (header);
+      stream->AddAtEnd (request);
+    }
+  NS_TEST_ASSERT_MSG_EQ (stream->GetSize (), 3 * HttpRequestParser::GetRequestSize (), "Wrong request size");
+
+  // Read in pieces that split the first request and coalesce the others
+  HttpRequestParser parser;
+  HTTPHeader header;
+  HTTPRequestHeader requestHeader;
+  uint32_t split = HttpRequestParser::GetRequestSize () / 2;
+
+  parser.Push (stream->CreateFragment (0, split));
+  NS_TEST_ASSERT_MSG_EQ (parser.Next (header, requestHeader), false, "Half a request was decoded");
+
+  parser.Push (stream->CreateFragment (split, stream->GetSize () - split));
+  for (uint32_t segment_id = 0; segment_id < 3; segment_id++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (parser.Next (header, requestHeader), true, "Request " << segment_id << " was lost");
+      NS_TEST_ASSERT_MSG_EQ (header.GetSegmentId (), segment_id, "Wrong segment");
+      NS_TEST_ASSERT_MSG_EQ (requestHeader.GetDeadline (), Seconds (segment_id + 1), "Wrong deadline");
+    }
+  NS_TEST_ASSERT_MSG_EQ (parser.Next (header, requestHeader), false, "Decoded a request that was not sent");
+  NS_TEST_ASSERT_MSG_EQ (parser.GetBufferedBytes (), 0, "Bytes were left in the parser");
+}
+
+// Checks that the player buffers and plays the frames it receives in order.
+class MpegPlayerTestCase : public TestCase
+{
+public:
+  MpegPlayerTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpegPlayerTestCase::MpegPlayerTestCase ()
+  : TestCase ("The player plays the buffered frames")
+{
+}
+
+void
+MpegPlayerTestCase::DoRun (void)
+{
+  MpegPlayer player;
+
+  // More frames than the initial ring holds
+  for (uint32_t segment_id = 0; segment_id < 3; segment_id++)
+    {
+      for (uint32_t f_id = 0; f_id < MPEG_FRAMES_PER_SEGMENT; f_id++)
+        {
+          HTTPHeader http_header;
+          http_header.SetResolution (45000 * (segment_id + 1));
+          http_header.SetSegmentId (segment_id);
+
+          MPEGHeader mpeg_header;
+          mpeg_header.SetFrameId (f_id);
+          mpeg_header.SetPlaybackTime (MilliSeconds ((f_id + segment_id * MPEG_FRAMES_PER_SEGMENT)
+                                                     * MPEG_TIME_BETWEEN_FRAMES));
+          player.ReceiveFrame (mpeg_header, http_header);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (player.GetQueueSize (), 3 * MPEG_FRAMES_PER_SEGMENT, "Frames were lost");
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (player.GetQueueSize (), 0, "Frames were left in the buffer");
+  NS_TEST_ASSERT_MSG_EQ (player.m_framesPlayed, 3 * MPEG_FRAMES_PER_SEGMENT, "Wrong number of frames played");
+  NS_TEST_ASSERT_MSG_EQ (player.m_totalRate, 6 * 45000 * MPEG_FRAMES_PER_SEGMENT, "Frames were played out of order");
+  NS_TEST_ASSERT_MSG_EQ (player.m_minRate, 90000, "Wrong minimum rate");
+  NS_TEST_ASSERT_MSG_EQ (player.m_state, MPEG_PLAYER_PAUSED, "The player should wait for more frames");
+}
+
+// Checks that the analytic playback yields the statistics of the per-frame one.
+class AnalyticPlaybackTestCase : public TestCase
+{
+public:
+  AnalyticPlaybackTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AnalyticPlaybackTestCase::AnalyticPlaybackTestCase ()
+  : TestCase ("Analytic playback matches per-frame playback")
+{
+}
+
+void
+AnalyticPlaybackTestCase::DoRun (void)
+{
+  MpegPlayer perFrame;
+  MpegPlayer analytic;
+  analytic.SetAnalytic (true);
+
+  // A segment every 2.3 s, that plays for 2 s, except for a late fourth one
+  for (uint32_t segment_id = 0; segment_id < 6; segment_id++)
+    {
+      Time arrival = MilliSeconds (500 + 2300 * segment_id + (segment_id == 3 ? 1700 : 0));
+      for (uint32_t f_id = 0; f_id < MPEG_FRAMES_PER_SEGMENT; f_id++)
+        {
+          HTTPHeader http_header;
+          http_header.SetResolution (45000 * (segment_id + 1));
+          http_header.SetSegmentId (segment_id);
+
+          MPEGHeader mpeg_header;
+          mpeg_header.SetFrameId (f_id);
+          mpeg_header.SetPlaybackTime (MilliSeconds ((f_id + segment_id * MPEG_FRAMES_PER_SEGMENT)
+                                                     * MPEG_TIME_BETWEEN_FRAMES));
+
+          Time at = arrival + MicroSeconds (1500 * f_id + 7);
+          Simulator::Schedule (at, &MpegPlayer::ReceiveFrame, &perFrame, mpeg_header, http_header);
+          Simulator::Schedule (at, &MpegPlayer::ReceiveFrame, &analytic, mpeg_header, http_header);
+        }
+    }
+  Simulator::Schedule (Seconds (12.345), &MpegPlayer::Stop, &perFrame);
+  Simulator::Schedule (Seconds (12.345), &MpegPlayer::Stop, &analytic);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_GT (perFrame.m_interrruptions, 1, "The scenario should stall");
+  NS_TEST_ASSERT_MSG_EQ (analytic.m_interrruptions, perFrame.m_interrruptions, "Different stall counts");
+  NS_TEST_ASSERT_MSG_EQ (analytic.m_interruption_time, perFrame.m_interruption_time, "Different interruption times");
+  NS_TEST_ASSERT_MSG_EQ (analytic.GetFramesPlayed (), perFrame.GetFramesPlayed (), "Different number of frames played");
+  NS_TEST_ASSERT_MSG_EQ (analytic.m_totalRate, perFrame.m_totalRate, "Different frames played");
+  NS_TEST_ASSERT_MSG_EQ (analytic.GetQueueSize (), perFrame.GetQueueSize (), "Different buffer levels");
+}
+
+// Checks the statistics of a sliding window as samples come and go.
+class SlidingWindowTestCase : public TestCase
+{
+public:
+  SlidingWindowTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SlidingWindowTestCase::SlidingWindowTestCase ()
+  : TestCase ("Sliding window statistics follow the samples in the window")
+{
+}
+
+void
+SlidingWindowTestCase::DoRun (void)
+{
+  SlidingWindow window;
+  window.Add (Seconds (1), 4);
+  window.Add (Seconds (2), 1);
+  window.Add (Seconds (3), 2);
+  window.Add (Seconds (4), 4);
+
+  NS_TEST_ASSERT_MSG_EQ (window.GetCount (), 4, "Wrong number of samples");
+  NS_TEST_ASSERT_MSG_EQ_TOL (window.GetMean (), 2.75, 1e-9, "Wrong mean");
+  NS_TEST_ASSERT_MSG_EQ_TOL (window.GetHarmonicMean (), 4 / 2.0, 1e-9, "Wrong harmonic mean");
+  NS_TEST_ASSERT_MSG_EQ (window.GetMin (), 1, "Wrong minimum");
+  NS_TEST_ASSERT_MSG_EQ (window.IsNonDecreasing (), false, "The samples decrease");
+
+  // The minimum and the decrease leave the window
+  window.Expire (Seconds (3));
+  NS_TEST_ASSERT_MSG_EQ (window.GetCount (), 2, "Wrong number of samples");
+  NS_TEST_ASSERT_MSG_EQ (window.GetMin (), 2, "Wrong minimum after expiry");
+  NS_TEST_ASSERT_MSG_EQ (window.IsNonDecreasing (), true, "The samples do not decrease");
+  NS_TEST_ASSERT_MSG_EQ (window.GetTime (1), Seconds (3), "Wrong time of the previous sample");
+
+  // A sample at the same time replaces the last one
+  window.Add (Seconds (4), 1);
+  NS_TEST_ASSERT_MSG_EQ (window.GetCount (), 2, "The sample should have been replaced");
+  NS_TEST_ASSERT_MSG_EQ (window.GetMin (), 1, "Wrong minimum after replacement");
+  NS_TEST_ASSERT_MSG_EQ_TOL (window.GetMean (), 1.5, 1e-9, "Wrong mean after replacement");
+  // The sample it had displaced is the minimum again
+  window.Add (Seconds (4), 5);
+  NS_TEST_ASSERT_MSG_EQ (window.GetMin (), 2, "Wrong minimum after a larger replacement");
+  NS_TEST_ASSERT_MSG_EQ (window.IsNonDecreasing (), true, "The samples do not decrease");
+
+  window.Expire (Seconds (10));
+  NS_TEST_ASSERT_MSG_EQ (window.IsEmpty (), true, "The window should be empty");
+  NS_TEST_ASSERT_MSG_EQ (window.GetMean (), 0, "An empty window has no mean");
+}
+
+// Checks the estimates of the throughput estimators on the same samples.
+class ThroughputEstimatorTestCase : public TestCase
+{
+public:
+  ThroughputEstimatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ThroughputEstimatorTestCase::ThroughputEstimatorTestCase ()
+  : TestCase ("Throughput estimators follow the segment bitrates")
+{
+}
+
+void
+ThroughputEstimatorTestCase::DoRun (void)
+{
+  Ptr<ThroughputEstimator> mean = CreateObject<MeanThroughputEstimator> ();
+  Ptr<ThroughputEstimator> harmonic = CreateObject<HarmonicMeanThroughputEstimator> ();
+  Ptr<ThroughputEstimator> ewma = CreateObject<EwmaThroughputEstimator> ();
+  Ptr<ThroughputEstimator> last = CreateObject<LastSampleThroughputEstimator> ();
+  Ptr<ThroughputEstimator> percentile = CreateObjectWithAttributes<PercentileThroughputEstimator> (
+      "Samples", UintegerValue (4), "Percentile", DoubleValue (50));
+
+  NS_TEST_ASSERT_MSG_EQ (ewma->GetEstimate (), 0, "No estimate before the first sample");
+  NS_TEST_ASSERT_MSG_EQ (percentile->GetEstimate (), 0, "No estimate before the first sample");
+
+  double samples[] = { 4e6, 1e6, 2e6, 4e6, 8e6 };
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      mean->AddSample (Seconds (2 * i), samples[i]);
+      harmonic->AddSample (Seconds (2 * i), samples[i]);
+      ewma->AddSample (Seconds (2 * i), samples[i]);
+      last->AddSample (Seconds (2 * i), samples[i]);
+      percentile->AddSample (Seconds (2 * i), samples[i]);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (mean->GetEstimate (), 3.8e6, 1, "Wrong mean");
+  NS_TEST_ASSERT_MSG_EQ_TOL (harmonic->GetEstimate (), 5 / (1 / 4e6 + 1 / 1e6 + 1 / 2e6 + 1 / 4e6 + 1 / 8e6),
+                             1, "Wrong harmonic mean");
+  NS_TEST_ASSERT_MSG_EQ (last->GetEstimate (), 8e6, "Wrong last sample");
+  // The first sample left the window, the lower median of the last four is 2e6
+  NS_TEST_ASSERT_MSG_EQ (percentile->GetEstimate (), 2e6, "Wrong percentile");
+
+  // The slow average lags behind the rise, and is the estimate
+  NS_TEST_ASSERT_MSG_LT (ewma->GetEstimate (), 8e6, "The estimate rose too fast");
+  NS_TEST_ASSERT_MSG_GT (ewma->GetEstimate (), 1e6, "The estimate fell too far");
+
+  // The fast average follows a drop, and is the estimate
+  double before = ewma->GetEstimate ();
+  ewma->AddSample (Seconds (10), 1e5);
+  NS_TEST_ASSERT_MSG_LT (ewma->GetEstimate (), before, "The estimate did not follow the drop");
+}
+
+// Checks the lookups of a bitrate ladder, and that ladders are per video.
+class BitrateLadderTestCase : public TestCase
+{
+public:
+  BitrateLadderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BitrateLadderTestCase::BitrateLadderTestCase ()
+  : TestCase ("Bitrate ladders look up the neighbouring bitrates")
+{
+}
+
+void
+BitrateLadderTestCase::DoRun (void)
+{
+  std::vector<uint32_t> rates;
+  rates.push_back (400000);
+  rates.push_back (100000);
+  rates.push_back (200000);
+  rates.push_back (200000);
+  Ptr<const BitrateLadder> ladder = Create<BitrateLadder> (rates);
+
+  NS_TEST_ASSERT_MSG_EQ (ladder->GetSize (), 3, "Duplicates should be dropped");
+  NS_TEST_ASSERT_MSG_EQ (ladder->GetRate (0), 100000, "The bitrates should be sorted");
+  NS_TEST_ASSERT_MSG_EQ (ladder->GetIndex (200000), 1, "Wrong index of a bitrate on the ladder");
+  NS_TEST_ASSERT_MSG_EQ (ladder->GetIndex (300000), 1, "Wrong index of a bitrate off the ladder");
+  NS_TEST_ASSERT_MSG_EQ (ladder->GetIndex (50000), 0, "Wrong index below the ladder");
+  NS_TEST_ASSERT_MSG_EQ (ladder->GetRateBelow (399999), 200000, "Wrong bitrate below");
+  NS_TEST_ASSERT_MSG_EQ (ladder->GetRateAbove (200001), 400000, "Wrong bitrate above");
+  NS_TEST_ASSERT_MSG_EQ (ladder->GetRateAbove (500000), 400000, "Wrong bitrate above the ladder");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ladder->GetStepUp (0), 1.0, 1e-9, "Wrong step up");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ladder->GetStepDown (2), 0.5, 1e-9, "Wrong step down");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ladder->GetMinStepDown (), 0.5, 1e-9, "Wrong minimum step down");
+
+  BitrateLadder::Set (42, ladder);
+  NS_TEST_ASSERT_MSG_EQ (BitrateLadder::Get (42), ladder, "The video should have its own ladder");
+  NS_TEST_ASSERT_MSG_EQ (BitrateLadder::Get (43), BitrateLadder::GetDefault (), "Other videos keep the default one");
+  BitrateLadder::Set (42, 0);
+  NS_TEST_ASSERT_MSG_EQ (BitrateLadder::Get (42), BitrateLadder::GetDefault (), "The default ladder should be restored");
+}
+
+// Checks that an MPD is parsed once, and what is taken from it.
+class MpdFileHandlerTestCase : public TestCase
+{
+public:
+  MpdFileHandlerTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpdFileHandlerTestCase::MpdFileHandlerTestCase ()
+  : TestCase ("Manifests are parsed once and give the ladder and segment timing")
+{
+}
+
+void
+MpdFileHandlerTestCase::DoRun (void)
+{
+  std::string path = CreateTempDirFilename ("video.mpd");
+  std::ofstream mpd (path.c_str ());
+  mpd << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl
+      << "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" mediaPresentationDuration=\"PT1M0.5S\">" << std::endl
+      << " <Period>" << std::endl
+      << "  <AdaptationSet contentType=\"audio\">" << std::endl
+      << "   <Representation id=\"a\" bandwidth=\"64000\"/>" << std::endl
+      << "  </AdaptationSet>" << std::endl
+      << "  <!-- 3 segments of 4 s, then 2 s ones until the end -->" << std::endl
+      << "  <AdaptationSet mimeType=\"video/mp4\" frameRate=\"30\">" << std::endl
+      << "   <SegmentTemplate timescale=\"1000\" media=\"$RepresentationID$/$Number$.m4s\">" << std::endl
+      << "    <SegmentTimeline><S t=\"0\" d=\"4000\" r=\"2\"/><S d=\"2000\" r=\"-1\"/></SegmentTimeline>" << std::endl
+      << "   </SegmentTemplate>" << std::endl
+      << "   <Representation id=\"hi\" bandwidth=\"500000\"/>" << std::endl
+      << "   <Representation id=\"lo\" bandwidth=\"250000\"/>" << std::endl
+      << "  </AdaptationSet>" << std::endl
+      << " </Period>" << std::endl
+      << "</MPD>" << std::endl;
+  mpd.close ();
+
+  MpdFileHandler *handler = MpdFileHandler::getInstance ();
+  uint32_t parses = handler->GetParses ();
+  NS_TEST_ASSERT_MSG_EQ (handler->Assign (77, path), true, "Could not parse the manifest");
+  NS_TEST_ASSERT_MSG_EQ (handler->Assign (78, path), true, "Could not parse the manifest");
+  NS_TEST_ASSERT_MSG_EQ (handler->GetParses (), parses + 1, "The manifest should be parsed once");
+
+  Ptr<const MpdManifest> manifest = handler->Get (77);
+  NS_TEST_ASSERT_MSG_EQ (manifest, handler->Get (78), "The manifest should be shared");
+  NS_TEST_ASSERT_MSG_EQ (manifest->GetLadder ()->GetSize (), 2, "The audio should not be on the ladder");
+  NS_TEST_ASSERT_MSG_EQ (BitrateLadder::Get (77)->GetLowest (), 250000, "The video should use the ladder of its manifest");
+  NS_TEST_ASSERT_MSG_EQ_TOL (manifest->GetFrameRate (), 30, 1e-9, "Wrong frame rate");
+  NS_TEST_ASSERT_MSG_EQ (manifest->GetSegmentDuration (2), Seconds (4), "Wrong duration of a timeline segment");
+  NS_TEST_ASSERT_MSG_EQ (manifest->GetSegmentDuration (3), Seconds (2), "Wrong duration of a repeated segment");
+  // 12 s of 4 s segments, then 48.5 s of 2 s ones
+  NS_TEST_ASSERT_MSG_EQ (manifest->GetSegmentCount (), 28, "Wrong number of segments");
+
+  // A timeline that starts late is numbered from its start, one with a
+  // gap, or a repeat count that does not fit, is rejected
+  const char *timelines[] = {
+    "<S t=\"90000\" d=\"2000\" r=\"1\"/><S t=\"94000\" d=\"4000\"/>",
+    "<S t=\"0\" d=\"2000\" r=\"1\"/><S t=\"6000\" d=\"2000\"/>",
+    "<S d=\"2000\" r=\"4294967295\"/>",
+    "<S d=\"2000\" r=\"-2\"/>"
+  };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      std::ostringstream name;
+      name << "timeline" << i << ".mpd";
+      std::string timelinePath = CreateTempDirFilename (name.str ());
+      std::ofstream timeline (timelinePath.c_str ());
+      timeline << "<MPD mediaPresentationDuration=\"PT8S\"><Period>" << std::endl
+               << " <AdaptationSet mimeType=\"video/mp4\" frameRate=\"25\">" << std::endl
+               << "  <SegmentTemplate timescale=\"1000\"><SegmentTimeline>" << timelines[i]
+               << "</SegmentTimeline></SegmentTemplate>" << std::endl
+               << "  <Representation id=\"v\" bandwidth=\"250000\"/>" << std::endl
+               << " </AdaptationSet>" << std::endl
+               << "</Period></MPD>" << std::endl;
+      timeline.close ();
+      NS_TEST_ASSERT_MSG_EQ (handler->Assign (79, timelinePath), i == 0, "Wrong handling of timeline " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (handler->Get (79)->GetSegmentCount (), 3, "Wrong number of segments");
+  NS_TEST_ASSERT_MSG_EQ (handler->Get (79)->GetSegmentDuration (2), Seconds (4), "Wrong duration after S@t");
+
+  BitrateLadder::Set (77, 0);
+  BitrateLadder::Set (78, 0);
+  BitrateLadder::Set (79, 0);
+}
+
+// Checks that the frames of a segment follow the timing of its video.
+class VideoTimingTestCase : public TestCase
+{
+public:
+  VideoTimingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+VideoTimingTestCase::VideoTimingTestCase ()
+  : TestCase ("Segments are made with the frame rate and length of their video")
+{
+}
+
+void
+VideoTimingTestCase::DoRun (void)
+{
+  VideoTiming defaults = VideoTiming::Get (90);
+  NS_TEST_ASSERT_MSG_EQ (defaults.GetFramesPerSegment (), MPEG_FRAMES_PER_SEGMENT, "Wrong default frames");
+  NS_TEST_ASSERT_MSG_EQ (defaults.GetSegmentDuration (), Seconds (2), "Wrong default segment length");
+
+  // 6 s segments at 25 fps
+  VideoTiming::Set (92, VideoTiming (150, MilliSeconds (40)));
+  NS_TEST_ASSERT_MSG_EQ (VideoTiming::Get (92).GetSegmentDuration (), Seconds (6), "Wrong segment length");
+
+  Ptr<SegmentCache> cache = CreateObject<SegmentCache> ();
+  Ptr<MpegSegment> segment = cache->CreateSegment (92, 1000000, 2);
+  NS_TEST_ASSERT_MSG_EQ (segment->frames.size (), 150, "Wrong number of frames");
+
+  MPEGHeader mpeg_header;
+  segment->frames[1]->PeekHeader (mpeg_header);
+  NS_TEST_ASSERT_MSG_EQ (mpeg_header.GetPlaybackTime (), MilliSeconds ((2 * 150 + 1) * 40), "Wrong playback time");
+  // A frame carries a frame interval of the bitrate, on average
+  uint32_t bytes = segment->bytes;
+  NS_TEST_ASSERT_MSG_GT (bytes, 150 * (1000000 * 0.04 / 8) * 0.8, "The frames are too small for their interval");
+
+  VideoTiming::Clear (92);
+  NS_TEST_ASSERT_MSG_EQ (VideoTiming::Get (92).GetFramesPerSegment (), MPEG_FRAMES_PER_SEGMENT, "The default should be restored");
+}
+
+// Checks that a whole segment response carries the frames of the segment.
+class SegmentResponseTestCase : public TestCase
+{
+public:
+  SegmentResponseTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SegmentResponseTestCase::SegmentResponseTestCase ()
+  : TestCase ("A segment response indexes the frames of the segment")
+{
+}
+
+void
+SegmentResponseTestCase::DoRun (void)
+{
+  Ptr<SegmentCache> cache = CreateObject<SegmentCache> ();
+  Ptr<MpegSegment> segment = cache->CreateSegment (1, 334000, 7);
+  Ptr<Packet> response = cache->CreateSegmentResponse (1, 334000, 7, VideoTiming::Get (1));
+
+  // The same bytes as the frames, so the transfer takes as long
+  NS_TEST_ASSERT_MSG_EQ (response->GetSize (), segment->bytes, "Wrong response size");
+
+  MPEGHeader mpeg_header;
+  HTTPHeader http_header;
+  response->RemoveHeader (mpeg_header);
+  response->RemoveHeader (http_header);
+  NS_TEST_ASSERT_MSG_EQ (mpeg_header.GetType (), MPEG_SEGMENT_RESPONSE, "Wrong response type");
+  NS_TEST_ASSERT_MSG_EQ (mpeg_header.GetFrameId (), segment->frames.size (), "Wrong number of frames");
+  NS_TEST_ASSERT_MSG_EQ (http_header.GetSegmentId (), 7, "Wrong segment");
+
+  std::vector<uint8_t> index (segment->frames.size () * MPEG_SEGMENT_INDEX_ENTRY);
+  response->CopyData (&index[0], index.size ());
+  for (uint32_t f_id = 0; f_id < segment->frames.size (); f_id++)
+    {
+      uint32_t size = (index[f_id * 4 + 1] << 16) | (index[f_id * 4 + 2] << 8) | index[f_id * 4 + 3];
+      segment->frames[f_id]->PeekHeader (mpeg_header);
+      NS_TEST_ASSERT_MSG_EQ (size, mpeg_header.GetSize (), "Wrong size in the index of frame " << f_id);
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) index[f_id * 4], mpeg_header.GetType (), "Wrong type of frame " << f_id);
+    }
+
+  // The cursor sends it in as many parts as needed
+  SegmentCursor cursor;
+  cursor.Push (1, 334000, 7, Time::Max (), true);
+  uint32_t sent = 0;
+  while (!cursor.IsEmpty ())
+    {
+      uint32_t part = std::min<uint32_t> (cursor.Peek (cache)->GetSize (), 1500);
+      cursor.Pop (part);
+      sent += part;
+    }
+  NS_TEST_ASSERT_MSG_EQ (sent, segment->bytes, "Wrong number of bytes sent");
+}
+
+// Checks that a connection can be asked for a range of the frames of a segment.
+class FrameRangeTestCase : public TestCase
+{
+public:
+  FrameRangeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FrameRangeTestCase::FrameRangeTestCase ()
+  : TestCase ("A frame range request sends the same frames as the whole segment")
+{
+}
+
+void
+FrameRangeTestCase::DoRun (void)
+{
+  HTTPRequestHeader request;
+  request.SetFrameRange (30, 20);
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (request);
+  HTTPRequestHeader received;
+  packet->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.HasFrameRange (), true, "The range was lost");
+  NS_TEST_ASSERT_MSG_EQ (received.GetFirstFrame (), 30, "Wrong first frame");
+  NS_TEST_ASSERT_MSG_EQ (received.GetFrameCount (), 20, "Wrong frame count");
+
+  Ptr<SegmentCache> cache = CreateObject<SegmentCache> ();
+  Ptr<MpegSegment> segment = cache->CreateSegment (1, 334000, 7);
+
+  // Without a cache, the frame sizes before the range are drawn and skipped
+  Ptr<SegmentCache> disabled = CreateObject<SegmentCache> ();
+  disabled->SetAttribute ("MaxBytes", UintegerValue (0));
+
+  SegmentCursor cursor;
+  cursor.Push (1, 334000, 7, Time::Max (), false, 30, 20);
+  for (uint32_t f_id = 30; f_id < 50; f_id++)
+    {
+      Ptr<Packet> frame = cursor.Peek (disabled);
+      MPEGHeader mpeg_header;
+      frame->PeekHeader (mpeg_header);
+      NS_TEST_ASSERT_MSG_EQ (mpeg_header.GetFrameId (), f_id, "Wrong frame id");
+      NS_TEST_ASSERT_MSG_EQ (frame->GetSize (), segment->frames[f_id]->GetSize (),
+                             "Frame " << f_id << " differs from the whole segment");
+      cursor.Pop ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (cursor.IsEmpty (), true, "Only the range should be sent");
+}
+
+// A client and a server on a point to point link, for the tests that play
+// a whole session. The segments the client receives are counted.
+class SessionFixture
+{
+public:
+  SessionFixture (const std::string &dataRate, const std::string &delay);
+
+  // Writes the manifest of a video of segments of 2 s at the given
+  // bitrates, and assigns it to the video
+  static bool AssignVideo (uint32_t videoId, const std::string &path, uint32_t segments,
+                           uint32_t frameRate, const std::vector<uint32_t> &bitrates);
+
+  // Adds a fog node, on a link of its own to the client
+  void AddFog (const std::string &dataRate, const std::string &delay);
+
+  // Points the client to the server, and the fog node if any, and installs
+  // it on the client node
+  void InstallClient (Ptr<DashClient> client, Time start, Time stop);
+  // Installs a DashServer on the server node, and on the fog node if any
+  void InstallServer (Time start, Time stop);
+  // Installs another DashServer on the fog node, which may follow one
+  // that stopped
+  void InstallFogServer (Time start, Time stop);
+  // Installs a CacheService on the server node instead
+  Ptr<CacheService> InstallCache (Time start, Time stop);
+  // Sets the rate of the link from the server to the client, after the delay
+  void SetServerRate (Time delay, const std::string &dataRate);
+
+  uint32_t GetSegments (void) const;
+
+private:
+  void SegmentReceived (uint32_t segment_id, uint32_t bitrate, uint32_t bytes, Time fetchTime);
+
+  NodeContainer m_nodes;        // The client, then the server
+  Ptr<PointToPointNetDevice> m_serverDevice;
+  Ipv4InterfaceContainer m_interfaces;
+  Ptr<Node> m_fog;
+  Ipv4InterfaceContainer m_fogInterfaces;
+  uint32_t m_segments;
+};
+
+SessionFixture::SessionFixture (const std::string &dataRate, const std::string &delay)
+  : m_segments (0)
+{
+  m_nodes.Create (2);
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue (dataRate));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue (delay));
+  NetDeviceContainer devices = pointToPoint.Install (m_nodes);
+  m_serverDevice = DynamicCast<PointToPointNetDevice> (devices.Get (1));
+
+  InternetStackHelper internet;
+  internet.Install (m_nodes);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  m_interfaces = ipv4.Assign (devices);
+}
+
+bool
+SessionFixture::AssignVideo (uint32_t videoId, const std::string &path, uint32_t segments,
+                             uint32_t frameRate, const std::vector<uint32_t> &bitrates)
+{
+  std::ofstream mpd (path.c_str ());
+  mpd << "<MPD mediaPresentationDuration=\"PT" << 2 * segments << "S\"><Period>" << std::endl
+      << " <AdaptationSet mimeType=\"video/mp4\" frameRate=\"" << frameRate << "\">" << std::endl
+      << "  <SegmentTemplate timescale=\"1000\" duration=\"2000\"/>" << std::endl;
+  for (uint32_t i = 0; i < bitrates.size (); i++)
+    {
+      mpd << "  <Representation id=\"v" << i << "\" bandwidth=\"" << bitrates[i] << "\"/>" << std::endl;
+    }
+  mpd << " </AdaptationSet>" << std::endl
+      << "</Period></MPD>" << std::endl;
+  mpd.close ();
+  return MpdFileHandler::getInstance ()->Assign (videoId, path);
+}
+
+void
+SessionFixture::AddFog (const std::string &dataRate, const std::string &delay)
+{
+  m_fog = CreateObject<Node> ();
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue (dataRate));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue (delay));
+  NetDeviceContainer devices = pointToPoint.Install (m_nodes.Get (0), m_fog);
+
+  InternetStackHelper internet;
+  internet.Install (m_fog);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.2.0", "255.255.255.0");
+  m_fogInterfaces = ipv4.Assign (devices);
+}
+
+void
+SessionFixture::InstallClient (Ptr<DashClient> client, Time start, Time stop)
+{
+  client->SetAttribute ("Remote", AddressValue (InetSocketAddress (m_interfaces.GetAddress (1), 80)));
+  if (m_fog)
+    {
+      client->SetAttribute ("FogRemote", AddressValue (InetSocketAddress (m_fogInterfaces.GetAddress (1), 80)));
+    }
+  client->TraceConnectWithoutContext ("SegmentReceived",
+                                      MakeCallback (&SessionFixture::SegmentReceived, this));
+  m_nodes.Get (0)->AddApplication (client);
+  client->SetStartTime (start);
+  client->SetStopTime (stop);
+}
+
+void
+SessionFixture::InstallServer (Time start, Time stop)
+{
+  DashServerHelper server ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), 80));
+  ApplicationContainer serverApp = server.Install (m_nodes.Get (1));
+  if (m_fog)
+    {
+      serverApp.Add (server.Install (m_fog));
+    }
+  serverApp.Start (start);
+  serverApp.Stop (stop);
+}
+
+void
+SessionFixture::InstallFogServer (Time start, Time stop)
+{
+  DashServerHelper server ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), 80));
+  ApplicationContainer serverApp = server.Install (m_fog);
+  serverApp.Start (start);
+  serverApp.Stop (stop);
+}
+
+Ptr<CacheService>
+SessionFixture::InstallCache (Time start, Time stop)
+{
+  Ptr<CacheService> cache = CreateObject<CacheService> ();
+  cache->SetAttribute ("Local", AddressValue (InetSocketAddress (Ipv4Address::GetAny (), 80)));
+  m_nodes.Get (1)->AddApplication (cache);
+  cache->SetStartTime (start);
+  cache->SetStopTime (stop);
+  return cache;
+}
+
+void
+SessionFixture::SetServerRate (Time delay, const std::string &dataRate)
+{
+  Simulator::Schedule (delay, &PointToPointNetDevice::SetDataRate, m_serverDevice, DataRate (dataRate));
+}
+
+uint32_t
+SessionFixture::GetSegments (void) const
+{
+  return m_segments;
+}
+
+void
+SessionFixture::SegmentReceived (uint32_t segment_id, uint32_t bitrate, uint32_t bytes, Time fetchTime)
+{
+  m_segments++;
+}
+
+// The clients of a single server, each on a link of its own to it.
+class StarFixture
+{
+public:
+  StarFixture (uint32_t clients, const std::string &dataRate, const std::string &delay);
+
+  // Installs a DashServer on the server node, whose attributes may still be set
+  Ptr<DashServer> InstallServer (Time start, Time stop);
+  // Points the client to the server over its link, and installs it on its node
+  void InstallClient (uint32_t index, Ptr<DashClient> client, Time start, Time stop);
+
+  Ptr<Node> GetClient (uint32_t index) const;
+  Ipv4Address GetClientAddress (uint32_t index) const;
+  Address GetRemote (uint32_t index) const;    // Of the server, over the link of the client
+  uint32_t GetSegments (uint32_t index) const;
+
+private:
+  static void SegmentReceived (uint32_t *segments, uint32_t segment_id, uint32_t bitrate,
+                               uint32_t bytes, Time fetchTime);
+
+  Ptr<Node> m_server;
+  NodeContainer m_clients;
+  std::vector<Ipv4InterfaceContainer> m_interfaces;     // The client, then the server, on each link
+  std::vector<uint32_t> m_segments;
+};
+
+StarFixture::StarFixture (uint32_t clients, const std::string &dataRate, const std::string &delay)
+  : m_segments (clients, 0)
+{
+  m_server = CreateObject<Node> ();
+  m_clients.Create (clients);
+  InternetStackHelper internet;
+  internet.Install (m_server);
+  internet.Install (m_clients);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue (dataRate));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue (delay));
+  Ipv4AddressHelper ipv4;
+  for (uint32_t i = 0; i < clients; i++)
+    {
+      NetDeviceContainer devices = pointToPoint.Install (m_clients.Get (i), m_server);
+      std::ostringstream base;
+      base << "10.2." << i + 1 << ".0";
+      ipv4.SetBase (base.str ().c_str (), "255.255.255.0");
+      m_interfaces.push_back (ipv4.Assign (devices));
+    }
+}
+
+Ptr<DashServer>
+StarFixture::InstallServer (Time start, Time stop)
+{
+  Ptr<DashServer> server = CreateObject<DashServer> ();
+  server->SetAttribute ("Local", AddressValue (InetSocketAddress (Ipv4Address::GetAny (), 80)));
+  m_server->AddApplication (server);
+  server->SetStartTime (start);
+  server->SetStopTime (stop);
+  return server;
+}
+
+void
+StarFixture::InstallClient (uint32_t index, Ptr<DashClient> client, Time start, Time stop)
+{
+  client->SetAttribute ("Remote", AddressValue (GetRemote (index)));
+  client->TraceConnectWithoutContext ("SegmentReceived",
+                                      MakeBoundCallback (&StarFixture::SegmentReceived, &m_segments[index]));
+  m_clients.Get (index)->AddApplication (client);
+  client->SetStartTime (start);
+  client->SetStopTime (stop);
+}
+
+Ptr<Node>
+StarFixture::GetClient (uint32_t index) const
+{
+  return m_clients.Get (index);
+}
+
+Ipv4Address
+StarFixture::GetClientAddress (uint32_t index) const
+{
+  return m_interfaces[index].GetAddress (0);
+}
+
+Address
+StarFixture::GetRemote (uint32_t index) const
+{
+  return InetSocketAddress (m_interfaces[index].GetAddress (1), 80);
+}
+
+uint32_t
+StarFixture::GetSegments (uint32_t index) const
+{
+  return m_segments[index];
+}
+
+void
+StarFixture::SegmentReceived (uint32_t *segments, uint32_t segment_id, uint32_t bitrate,
+                              uint32_t bytes, Time fetchTime)
+{
+  (*segments)++;
+}
+
+// A client that asks for the highest bitrate, and keeps the lower one an
+// abandoned request leaves it at.
+class TopRateClient : public DashClient
+{
+private:
+  virtual void CalcNextSegment (uint32_t currRate, uint32_t &nextRate, Time &delay);
+};
+
+void
+TopRateClient::CalcNextSegment (uint32_t currRate, uint32_t &nextRate, Time &delay)
+{
+  // The first segment is requested at the lowest bitrate
+  uint32_t highest = GetLadder ()->GetHighest ();
+  nextRate = m_segmentId > 1 && currRate < highest ? currRate : highest;
+  delay = Seconds (0);
+}
+
+// Checks that a cancelled segment stops after the frames already sent, and
+// that the requests queued behind it are kept.
+class CancelTestCase : public TestCase
+{
+public:
+  CancelTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CancelTestCase::CancelTestCase ()
+  : TestCase ("A cancelled segment stops after the frames already sent")
+{
+}
+
+void
+CancelTestCase::DoRun (void)
+{
+  HTTPRequestHeader request;
+  request.SetCancel (true);
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (request);
+  HTTPRequestHeader received;
+  packet->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.IsCancel (), true, "The cancel flag was lost");
+
+  Ptr<SegmentCache> cache = CreateObject<SegmentCache> ();
+  SegmentCursor cursor;
+  cursor.Push (1, 334000, 7);
+  cursor.Push (1, 334000, 8);
+  cursor.Push (1, 334000, 7, Time::Max (), false, 30, 20);
+  for (uint32_t f_id = 0; f_id < 3; f_id++)
+    {
+      cursor.Peek (cache);
+      cursor.Pop ();
+    }
+  cursor.Peek (cache); // Made, but not sent
+  NS_TEST_ASSERT_MSG_EQ (cursor.Cancel (1, 7), 2, "Both requests of the segment should be cut");
+  NS_TEST_ASSERT_MSG_EQ (cursor.GetPending (), 1, "The next segment should be kept");
+
+  HTTPHeader http_header;
+  MPEGHeader mpeg_header;
+  Ptr<Packet> frame = cursor.Peek (cache)->Copy ();
+  frame->RemoveHeader (mpeg_header);
+  frame->RemoveHeader (http_header);
+  NS_TEST_ASSERT_MSG_EQ (http_header.GetSegmentId (), 8, "Wrong segment after the cancel");
+  NS_TEST_ASSERT_MSG_EQ (mpeg_header.GetFrameId (), 0, "The next segment should start at its first frame");
+
+  // A whole segment response that has started is finished
+  SegmentCursor whole;
+  whole.Push (1, 334000, 7, Time::Max (), true);
+  whole.Pop (whole.Peek (cache)->GetSize () / 2);
+  NS_TEST_ASSERT_MSG_EQ (whole.Cancel (1, 7), 0, "A started response should not be cut");
+  NS_TEST_ASSERT_MSG_EQ (whole.IsEmpty (), false, "The rest of the response should be sent");
+}
+
+// Checks that a client abandons the segment its link slows down under, and
+// plays on at the lower bitrate it requests the remaining frames at.
+class AbandonTestCase : public TestCase
+{
+public:
+  AbandonTestCase ();
+
+private:
+  virtual void DoRun (void);
+  static void SegmentReceived (SessionFixture *session, uint32_t segment_id, uint32_t bitrate,
+                               uint32_t bytes, Time fetchTime);
+  static void RequestAbandoned (std::vector<uint32_t> *abandoned, uint32_t segment_id, uint32_t from,
+                                uint32_t to, uint32_t frame_id);
+};
+
+AbandonTestCase::AbandonTestCase ()
+  : TestCase ("A request that would stall the player is abandoned for a lower bitrate")
+{
+}
+
+void
+AbandonTestCase::SegmentReceived (SessionFixture *session, uint32_t segment_id, uint32_t bitrate,
+                                  uint32_t bytes, Time fetchTime)
+{
+  // A few frames of the next segment arrive before the link slows down
+  if (segment_id == 5)
+    {
+      session->SetServerRate (MilliSeconds (100), "1Mbps");
+    }
+}
+
+void
+AbandonTestCase::RequestAbandoned (std::vector<uint32_t> *abandoned, uint32_t segment_id, uint32_t from,
+                                   uint32_t to, uint32_t frame_id)
+{
+  abandoned->push_back (segment_id);
+  abandoned->push_back (from);
+  abandoned->push_back (to);
+  abandoned->push_back (frame_id);
+}
+
+void
+AbandonTestCase::DoRun (void)
+{
+  // 12 segments of 2 s, whose highest bitrate takes 8 s a segment once the link slows down
+  std::vector<uint32_t> bitrates;
+  bitrates.push_back (250000);
+  bitrates.push_back (4000000);
+  NS_TEST_ASSERT_MSG_EQ (SessionFixture::AssignVideo (82, CreateTempDirFilename ("abandon.mpd"), 12, 25, bitrates),
+                         true, "Could not parse the manifest");
+
+  SessionFixture session ("6Mbps", "10ms");
+  Ptr<DashClient> client = CreateObject<TopRateClient> ();
+  client->SetAttribute ("VideoId", UintegerValue (82));
+  client->SetAttribute ("AbandonRequests", BooleanValue (true));
+  session.InstallClient (client, Seconds (1.0), Seconds (60.0));
+  session.InstallServer (Seconds (0.0), Seconds (65.0));
+
+  std::vector<uint32_t> abandoned;
+  client->TraceConnectWithoutContext ("SegmentReceived",
+                                      MakeBoundCallback (&AbandonTestCase::SegmentReceived, &session));
+  client->TraceConnectWithoutContext ("RequestAbandoned",
+                                      MakeBoundCallback (&AbandonTestCase::RequestAbandoned, &abandoned));
+
+  Simulator::Run ();
+  uint32_t interruptions = client->GetPlayer ().m_interrruptions;
+  uint32_t segments = session.GetSegments ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (abandoned.empty (), false, "The slowed down segment should be abandoned");
+  NS_TEST_ASSERT_MSG_EQ (abandoned[0], 6, "The segment under the slow link should be abandoned");
+  NS_TEST_ASSERT_MSG_EQ (abandoned[1], 4000000, "It was requested at the highest bitrate");
+  NS_TEST_ASSERT_MSG_EQ (abandoned[2], 250000, "Its remaining frames should be requested at the lower one");
+  NS_TEST_ASSERT_MSG_EQ (abandoned[3] >= 5, true, "Not before AbandonMinFrames frames");
+  NS_TEST_ASSERT_MSG_EQ (segments, 12, "Every segment should be received");
+  NS_TEST_ASSERT_MSG_EQ (interruptions, 0, "The player should not stall");
+
+  BitrateLadder::Set (82, 0);
+}
+
+// Checks that pipelined requests keep the link busy on a long RTT path.
+class PipelineTestCase : public TestCase
+{
+public:
+  PipelineTestCase ();
+
+private:
+  virtual void DoRun (void);
+  double Run (uint32_t depth, uint32_t connections, uint32_t chunkFrames = 0);   // The goodput of a client
+
+  uint32_t m_segments;
+};
+
+PipelineTestCase::PipelineTestCase ()
+  : TestCase ("Pipelined requests raise the goodput on a long RTT path"),
+    m_segments (0)
+{
+}
+
+double
+PipelineTestCase::Run (uint32_t depth, uint32_t connections, uint32_t chunkFrames)
+{
+  SessionFixture session ("5Mbps", "100ms");
+  Ptr<DashClient> client = CreateObject<DashClient> ();
+  client->SetAttribute ("VideoId", UintegerValue (80));
+  client->SetAttribute ("PipelineDepth", UintegerValue (depth));
+  client->SetAttribute ("Connections", UintegerValue (connections));
+  client->SetAttribute ("ChunkFrames", UintegerValue (chunkFrames));
+  session.InstallClient (client, Seconds (1.0), Seconds (60.0));
+  session.InstallServer (Seconds (0.0), Seconds (65.0));
+
+  Simulator::Run ();
+  double goodput = client->GetGoodput ();
+  m_segments = session.GetSegments ();
+  Simulator::Destroy ();
+  return goodput;
+}
+
+void
+PipelineTestCase::DoRun (void)
+{
+  // 15 segments of 2 s at a single bitrate
+  NS_TEST_ASSERT_MSG_EQ (SessionFixture::AssignVideo (80, CreateTempDirFilename ("pipeline.mpd"), 15, 50,
+                                                      std::vector<uint32_t> (1, 200000)),
+                         true, "Could not parse the manifest");
+
+  double stopAndWait = Run (1, 1);
+  NS_TEST_ASSERT_MSG_EQ (m_segments, 15, "Stop and wait should receive every segment");
+  double pipelined = Run (3, 1);
+  NS_TEST_ASSERT_MSG_EQ (m_segments, 15, "Pipelining should receive every segment");
+  // The frames of the three connections are put back in order
+  Run (1, 3);
+  NS_TEST_ASSERT_MSG_EQ (m_segments, 15, "Split segments should all be received");
+  // Each segment is requested in 5 frame ranges, the last one short
+  Run (2, 1, 22);
+  NS_TEST_ASSERT_MSG_EQ (m_segments, 15, "Chunked segments should all be received");
+
+  // Each stop and wait segment pays an idle round trip of 200 ms
+  NS_TEST_ASSERT_MSG_GT (pipelined, stopAndWait * 1.2, "Pipelining should raise the goodput");
+
+  BitrateLadder::Set (80, 0);
+}
+
+// Checks that the chunks of a segment follow the throughput down, that the
+// cache sends only the frames each chunk asks for, and that a pipelined
+// segment waits until the chunks of the one before it are requested.
+class ChunkTestCase : public TestCase
+{
+public:
+  ChunkTestCase ();
+
+private:
+  // A request of the client, or a frame of the cache
+  struct Sent
+  {
+    uint32_t segment;
+    uint32_t rate;
+    uint32_t first;     // Frame
+    uint32_t count;     // Frames, 1 for a frame of the cache
+  };
+
+  virtual void DoRun (void);
+  void Run (uint32_t depth, bool slowDown);
+  static void SegmentReceived (SessionFixture *session, uint32_t segment_id, uint32_t bitrate,
+                               uint32_t bytes, Time fetchTime);
+  static void RequestSent (std::vector<Sent> *requests, Ptr<const Packet> packet);
+  static void FrameSent (std::vector<Sent> *frames, Ptr<const Packet> packet);
+
+  std::vector<Sent> m_requests;
+  std::vector<Sent> m_frames;
+  uint32_t m_segments;
+};
+
+ChunkTestCase::ChunkTestCase ()
+  : TestCase ("The chunks of a segment are requested in order at the bitrate the throughput sustains"),
+    m_segments (0)
+{
+}
+
+void
+ChunkTestCase::SegmentReceived (SessionFixture *session, uint32_t segment_id, uint32_t bitrate,
+                                uint32_t bytes, Time fetchTime)
+{
+  // A few frames of the next segment arrive before the link slows down
+  if (segment_id == 2)
+    {
+      session->SetServerRate (MilliSeconds (100), "500kbps");
+    }
+}
+
+void
+ChunkTestCase::RequestSent (std::vector<Sent> *requests, Ptr<const Packet> packet)
+{
+  Ptr<Packet> copy = packet->Copy ();
+  HTTPHeader http_header;
+  HTTPRequestHeader request;
+  copy->RemoveHeader (http_header);
+  copy->RemoveHeader (request);
+  Sent sent = { http_header.GetSegmentId (), http_header.GetResolution (), request.GetFirstFrame (),
+                request.HasFrameRange () ? request.GetFrameCount () : 50 };
+  requests->push_back (sent);
+}
+
+void
+ChunkTestCase::FrameSent (std::vector<Sent> *frames, Ptr<const Packet> packet)
+{
+  Ptr<Packet> copy = packet->Copy ();
+  MPEGHeader mpeg_header;
+  HTTPHeader http_header;
+  copy->RemoveHeader (mpeg_header);
+  copy->RemoveHeader (http_header);
+  Sent sent = { http_header.GetSegmentId (), http_header.GetResolution (), mpeg_header.GetFrameId (), 1 };
+  frames->push_back (sent);
+}
+
+void
+ChunkTestCase::Run (uint32_t depth, bool slowDown)
+{
+  SessionFixture session ("6Mbps", "10ms");
+  Ptr<DashClient> client = CreateObject<TopRateClient> ();
+  client->SetAttribute ("VideoId", UintegerValue (83));
+  client->SetAttribute ("PipelineDepth", UintegerValue (depth));
+  client->SetAttribute ("ChunkFrames", UintegerValue (10));
+  session.InstallClient (client, Seconds (1.0), Seconds (120.0));
+  Ptr<CacheService> cache = session.InstallCache (Seconds (0.0), Seconds (125.0));
+
+  m_requests.clear ();
+  m_frames.clear ();
+  client->TraceConnectWithoutContext ("Tx", MakeBoundCallback (&ChunkTestCase::RequestSent, &m_requests));
+  cache->TraceConnectWithoutContext ("Tx", MakeBoundCallback (&ChunkTestCase::FrameSent, &m_frames));
+  if (slowDown)
+    {
+      client->TraceConnectWithoutContext ("SegmentReceived",
+                                          MakeBoundCallback (&ChunkTestCase::SegmentReceived, &session));
+    }
+
+  Simulator::Run ();
+  m_segments = session.GetSegments ();
+  Simulator::Destroy ();
+}
+
+void
+ChunkTestCase::DoRun (void)
+{
+  // 6 segments of 50 frames, requested in chunks of 10
+  std::vector<uint32_t> bitrates;
+  bitrates.push_back (250000);
+  bitrates.push_back (4000000);
+  NS_TEST_ASSERT_MSG_EQ (SessionFixture::AssignVideo (83, CreateTempDirFilename ("chunk.mpd"), 6, 25, bitrates),
+                         true, "Could not parse the manifest");
+
+  Run (1, true);
+  NS_TEST_ASSERT_MSG_EQ (m_segments, 6, "Every segment should be received");
+
+  // Segment 3 starts at the highest bitrate, and a later chunk of it drops
+  // to the lower one once the link has slowed down
+  uint32_t lowered = m_requests.size ();
+  bool highest = false;
+  for (uint32_t i = 0; i < m_requests.size () && lowered == m_requests.size (); i++)
+    {
+      if (m_requests[i].segment != 3)
+        {
+          continue;
+        }
+      if (m_requests[i].rate == 4000000)
+        {
+          highest = true;
+        }
+      else if (highest && m_requests[i].first > 0)
+        {
+          lowered = i;
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (highest, true, "Segment 3 should start at the highest bitrate");
+  NS_TEST_ASSERT_MSG_LT (lowered, m_requests.size (), "A later chunk of segment 3 should be lowered");
+  NS_TEST_ASSERT_MSG_EQ (m_requests[lowered].rate, 250000, "Wrong bitrate of the lowered chunk");
+
+  // The cache sends the frames of each range, once, and no other
+  std::vector<uint64_t> requested;
+  std::vector<uint64_t> sent;
+  for (uint32_t i = 0; i < m_requests.size (); i++)
+    {
+      for (uint32_t f_id = m_requests[i].first; f_id < m_requests[i].first + m_requests[i].count; f_id++)
+        {
+          requested.push_back (((uint64_t) m_requests[i].segment << 32) | (m_requests[i].rate << 8) | f_id);
+        }
+    }
+  for (uint32_t i = 0; i < m_frames.size (); i++)
+    {
+      sent.push_back (((uint64_t) m_frames[i].segment << 32) | (m_frames[i].rate << 8) | m_frames[i].first);
+      if (m_frames[i].segment == m_requests[lowered].segment && m_frames[i].first >= m_requests[lowered].first
+          && m_frames[i].first < m_requests[lowered].first + m_requests[lowered].count)
+        {
+          NS_TEST_ASSERT_MSG_EQ (m_frames[i].rate, 250000, "The frames of the lowered chunk should arrive lowered");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (sent.size (), 6 * 50, "Each frame should be sent once");
+  std::sort (requested.begin (), requested.end ());
+  std::sort (sent.begin (), sent.end ());
+  NS_TEST_ASSERT_MSG_EQ ((requested == sent), true, "The cache should send the requested frames only");
+
+  // With two segments outstanding, the next segment is requested after the
+  // last chunk of the one before it
+  Run (2, false);
+  NS_TEST_ASSERT_MSG_EQ (m_segments, 6, "Every pipelined segment should be received");
+  std::vector<uint32_t> requestedEnd (6, 0);
+  for (uint32_t i = 0; i < m_requests.size (); i++)
+    {
+      const Sent &request = m_requests[i];
+      if (request.segment > 0 && requestedEnd[request.segment] == 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (requestedEnd[request.segment - 1], 50,
+                                 "Segment " << request.segment << " was requested before the chunks of the previous one");
+        }
+      requestedEnd[request.segment] = std::max (requestedEnd[request.segment], request.first + request.count);
+    }
+
+  BitrateLadder::Set (83, 0);
+}
+
+// Checks that an endpoint is only chosen when it predicts a shorter fetch time by the margin.
+class EdgeSelectorTestCase : public TestCase
+{
+public:
+  EdgeSelectorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+EdgeSelectorTestCase::EdgeSelectorTestCase ()
+  : TestCase ("The edge selector switches on a predicted gain larger than its margin")
+{
+}
+
+void
+EdgeSelectorTestCase::DoRun (void)
+{
+  EdgeSelector edges;
+  edges.SetMargin (0.2);
+  edges.AddRtt (0, Seconds (1), MilliSeconds (200));
+  edges.AddThroughput (0, Seconds (1), 2e6);
+  NS_TEST_ASSERT_MSG_EQ (edges.HasData (1), false, "The other endpoint has no data");
+  NS_TEST_ASSERT_MSG_EQ (edges.Select (0, 1, 1e6), 0, "An endpoint without data should not be chosen");
+
+  // 0.7 s on the first endpoint, 0.62 s on the second one: not enough
+  edges.AddRtt (1, Seconds (2), MilliSeconds (20));
+  edges.AddThroughput (1, Seconds (2), 1.67e6);
+  NS_TEST_ASSERT_MSG_EQ_TOL (edges.PredictFetchTime (0, 1e6).GetSeconds (), 0.7, 1e-6, "Wrong prediction");
+  NS_TEST_ASSERT_MSG_EQ (edges.Select (0, 1, 1e6), 0, "The gain is below the margin");
+
+  // The average moves by a quarter of each sample
+  edges.AddThroughput (1, Seconds (3), 10e6);
+  NS_TEST_ASSERT_MSG_EQ_TOL (edges.GetThroughput (1), 0.75 * 1.67e6 + 0.25 * 10e6, 1, "Wrong average");
+  NS_TEST_ASSERT_MSG_EQ (edges.Select (0, 1, 1e6), 1, "The gain is above the margin");
+  NS_TEST_ASSERT_MSG_EQ (edges.GetLastUpdate (1), Seconds (3), "Wrong update time");
+}
+
+// Checks that a client whose server is not up yet connects again until it is,
+// and then receives the whole video.
+class ReconnectTestCase : public TestCase
+{
+public:
+  ReconnectTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ReconnectTestCase::ReconnectTestCase ()
+  : TestCase ("A failed connection is retried with backoff")
+{
+}
+
+void
+ReconnectTestCase::DoRun (void)
+{
+  // 5 segments of 2 s at a single bitrate
+  NS_TEST_ASSERT_MSG_EQ (SessionFixture::AssignVideo (81, CreateTempDirFilename ("reconnect.mpd"), 5, 25,
+                                                      std::vector<uint32_t> (1, 200000)),
+                         true, "Could not parse the manifest");
+
+  SessionFixture session ("5Mbps", "10ms");
+  Ptr<DashClient> client = CreateObject<DashClient> ();
+  client->SetAttribute ("VideoId", UintegerValue (81));
+  session.InstallClient (client, Seconds (1.0), Seconds (30.0));
+  // The first handshakes are refused
+  session.InstallServer (Seconds (2.0), Seconds (35.0));
+
+  Simulator::Run ();
+  uint32_t failures = client->GetConnectionPool ().GetFailures ();
+  uint32_t segments = session.GetSegments ();
+  // Only the socket of the reconnection ever saw a round trip
+  bool transport = client->GetTransportStats (DashClient::CLOUD_EDGE).HasData ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_GT (failures, 0, "The first handshake should have failed");
+  NS_TEST_ASSERT_MSG_EQ (segments, 5, "Every segment should be received once connected");
+  NS_TEST_ASSERT_MSG_EQ (transport, true, "The traces of the new socket should be followed");
+
+  BitrateLadder::Set (81, 0);
+}
+
+// Checks that a fog segment lost in flight is received whole once the fog
+// node is connected again, with no probe taking its frames.
+class FogReconnectTestCase : public TestCase
+{
+public:
+  FogReconnectTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FogReconnectTestCase::FogReconnectTestCase ()
+  : TestCase ("A fog segment lost in flight is sent again before any probe")
+{
+}
+
+void
+FogReconnectTestCase::DoRun (void)
+{
+  // 30 segments of 2 s at a single bitrate, of about 1 s each on the fog link
+  NS_TEST_ASSERT_MSG_EQ (SessionFixture::AssignVideo (85, CreateTempDirFilename ("fogreconnect.mpd"), 30, 25,
+                                                      std::vector<uint32_t> (1, 1000000)),
+                         true, "Could not parse the manifest");
+
+  // The fog node is the faster endpoint, so the segments move to it and
+  // follow one another there, and one of them is in flight when it stops.
+  // The server is installed before the fog node is added, which gets two
+  // servers of its own
+  SessionFixture session ("500kbps", "50ms");
+  session.InstallServer (Seconds (0.0), Seconds (105.0));
+  session.AddFog ("2Mbps", "2ms");
+  session.InstallFogServer (Seconds (0.0), Seconds (15.0));
+  session.InstallFogServer (Seconds (15.5), Seconds (105.0));
+  Ptr<TopRateClient> client = CreateObject<TopRateClient> ();
+  client->SetAttribute ("VideoId", UintegerValue (85));
+  client->SetAttribute ("EdgeSelection", EnumValue (DashClient::DYNAMIC_EDGE));
+  session.InstallClient (client, Seconds (1.0), Seconds (100.0));
+
+  Simulator::Run ();
+  uint32_t failures = client->GetConnectionPool ().GetFailures ();
+  uint32_t segments = session.GetSegments ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_GT (failures, 0, "The fog connection should have been lost");
+  NS_TEST_ASSERT_MSG_EQ (segments, 30, "The lost segment should be received whole");
+
+  BitrateLadder::Set (85, 0);
+}
+
+// Checks that the read samples keep the last reads only.
+class ReadSampleRingTestCase : public TestCase
+{
+public:
+  ReadSampleRingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ReadSampleRingTestCase::ReadSampleRingTestCase ()
+  : TestCase ("The read sample ring keeps the last reads in a fixed space")
+{
+}
+
+void
+ReadSampleRingTestCase::DoRun (void)
+{
+  ReadSampleRing reads;
+  reads.SetCapacity (3);
+  NS_TEST_ASSERT_MSG_EQ (reads.GetThroughput (Seconds (0)), 0, "No samples, no throughput");
+
+  for (uint32_t i = 1; i <= 5; i++)
+    {
+      reads.Add (Seconds (i), 1000 * i, MilliSeconds (100));
+    }
+  NS_TEST_ASSERT_MSG_EQ (reads.GetCount (), 3, "The ring should be full");
+  NS_TEST_ASSERT_MSG_EQ (reads.GetTotal (), 5, "Wrong number of samples added");
+  NS_TEST_ASSERT_MSG_EQ (reads.Get ().bytes, 5000, "Wrong last sample");
+  NS_TEST_ASSERT_MSG_EQ (reads.Get (2).time, Seconds (3), "The oldest samples should be dropped");
+
+  // The last two reads: 9000 bytes in 200 ms
+  NS_TEST_ASSERT_MSG_EQ_TOL (reads.GetThroughput (Seconds (3)), 8 * 9000 / 0.2, 1e-6, "Wrong throughput");
+
+  // Two connections read at once: the 150 ms their intervals cover is
+  // counted once, and only from the given time on
+  ReadSampleRing parallel;
+  parallel.Add (Seconds (10), 1000, MilliSeconds (100));
+  parallel.Add (Seconds (10.05), 1000, MilliSeconds (100));
+  NS_TEST_ASSERT_MSG_EQ_TOL (parallel.GetThroughput (Seconds (0)), 8 * 2000 / 0.15, 1e-6,
+                             "Overlapping intervals should be counted once");
+  NS_TEST_ASSERT_MSG_EQ_TOL (parallel.GetThroughput (Seconds (9.95)), 8 * 2000 / 0.1, 1e-6,
+                             "The intervals should be cut at the given time");
+}
+
+class TransportStatsTestCase : public TestCase
+{
+public:
+  TransportStatsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TransportStatsTestCase::TransportStatsTestCase ()
+  : TestCase ("The transport statistics estimate a window per round trip")
+{
+}
+
+void
+TransportStatsTestCase::DoRun (void)
+{
+  TransportStats stats;
+  stats.SetCwnd (10000);
+  NS_TEST_ASSERT_MSG_EQ (stats.HasData (), false, "No round trip yet");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetBandwidthEstimate (), 0, "No round trip, no estimate");
+
+  stats.AddRtt (Seconds (0)); // Not measured
+  stats.AddRtt (MilliSeconds (80));
+  NS_TEST_ASSERT_MSG_EQ (stats.GetRtt (), MilliSeconds (80), "The first round trip is taken as is");
+  NS_TEST_ASSERT_MSG_EQ_TOL (stats.GetBandwidthEstimate (), 8 * 10000 / 0.08, 1e-6, "Wrong estimate");
+
+  // Smoothed with a weight of 1/8
+  stats.AddRtt (MilliSeconds (160));
+  NS_TEST_ASSERT_MSG_EQ (stats.GetRtt (), MilliSeconds (90), "Wrong smoothed round trip");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetMinRtt (), MilliSeconds (80), "Wrong minimum round trip");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetRttSamples (), 2, "Wrong number of round trips");
+
+  stats.AddLoss ();
+  NS_TEST_ASSERT_MSG_EQ (stats.GetLosses (), 1, "Wrong number of losses");
+
+  stats.Reset ();
+  NS_TEST_ASSERT_MSG_EQ (stats.HasData (), false, "A new connection starts over");
+}
+
+// A client that asks for the highest bitrate below its estimate, and keeps
+// the estimates it decided on.
+class EstimateClient : public DashClient
+{
+public:
+  const std::vector<std::pair<Time, double> >& GetEstimates (void) const;
+
+private:
+  virtual void CalcNextSegment (uint32_t currRate, uint32_t &nextRate, Time &delay);
+
+  std::vector<std::pair<Time, double> > m_estimates;
+};
+
+const std::vector<std::pair<Time, double> >&
+EstimateClient::GetEstimates (void) const
+{
+  return m_estimates;
+}
+
+void
+EstimateClient::CalcNextSegment (uint32_t currRate, uint32_t &nextRate, Time &delay)
+{
+  m_estimates.push_back (std::make_pair (Simulator::Now (), GetBitRateEstimate ()));
+  nextRate = GetLadder ()->GetRateBelow (GetBitRateEstimate ());
+  delay = Seconds (0);
+}
+
+// Checks that the client follows the TCP state of its connections, and that
+// its estimate starts over from the connection to the fog node it moves to.
+class TransportColdStartTestCase : public TestCase
+{
+public:
+  TransportColdStartTestCase ();
+
+private:
+  // A throughput sample, of a segment or of a connection
+  struct Sample
+  {
+    Time time;
+    double bitrate;
+  };
+
+  virtual void DoRun (void);
+  static void SegmentReceived (std::vector<Sample> *samples, uint32_t segment_id, uint32_t bitrate,
+                               uint32_t bytes, Time fetchTime);
+  static void EstimateSeeded (std::vector<Sample> *seeds, uint32_t edge, double bitrate);
+};
+
+TransportColdStartTestCase::TransportColdStartTestCase ()
+  : TestCase ("The estimate starts over from the TCP state of the fog connection")
+{
+}
+
+void
+TransportColdStartTestCase::SegmentReceived (std::vector<Sample> *samples, uint32_t segment_id,
+                                             uint32_t bitrate, uint32_t bytes, Time fetchTime)
+{
+  Sample sample = { Simulator::Now (), 8.0 * bytes / fetchTime.GetSeconds () };
+  samples->push_back (sample);
+}
+
+void
+TransportColdStartTestCase::EstimateSeeded (std::vector<Sample> *seeds, uint32_t edge, double bitrate)
+{
+  if (edge == DashClient::FOG_EDGE)
+    {
+      Sample seed = { Simulator::Now (), bitrate };
+      seeds->push_back (seed);
+    }
+}
+
+void
+TransportColdStartTestCase::DoRun (void)
+{
+  std::vector<uint32_t> bitrates;
+  bitrates.push_back (250000);
+  bitrates.push_back (1000000);
+  bitrates.push_back (4000000);
+  NS_TEST_ASSERT_MSG_EQ (SessionFixture::AssignVideo (84, CreateTempDirFilename ("coldstart.mpd"), 10, 25, bitrates),
+                         true, "Could not parse the manifest");
+
+  // The fog node is probed once connected, and predicts a far shorter fetch time
+  SessionFixture session ("2Mbps", "50ms");
+  session.AddFog ("50Mbps", "2ms");
+  Ptr<EstimateClient> client = CreateObject<EstimateClient> ();
+  client->SetAttribute ("VideoId", UintegerValue (84));
+  session.InstallClient (client, Seconds (1.0), Seconds (60.0));
+  session.InstallServer (Seconds (0.0), Seconds (65.0));
+
+  std::vector<Sample> samples;
+  std::vector<Sample> seeds;
+  client->TraceConnectWithoutContext ("SegmentReceived",
+                                      MakeBoundCallback (&TransportColdStartTestCase::SegmentReceived, &samples));
+  client->TraceConnectWithoutContext ("EstimateSeeded",
+                                      MakeBoundCallback (&TransportColdStartTestCase::EstimateSeeded, &seeds));
+
+  Simulator::Run ();
+  TransportStats fog = client->GetTransportStats (DashClient::FOG_EDGE);
+  std::vector<std::pair<Time, double> > estimates = client->GetEstimates ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (fog.HasData (), true, "The traces of the fog socket should be followed");
+  NS_TEST_ASSERT_MSG_GT (fog.GetRtt (), Seconds (0), "The fog connection should have a round trip");
+  NS_TEST_ASSERT_MSG_EQ (seeds.empty (), false, "The requests should move to the fog node");
+  NS_TEST_ASSERT_MSG_GT (seeds[0].bitrate, 0, "The seed should come from the window per round trip");
+
+  // The first decision after the switch sees the seed, averaged with the
+  // fog segments received since, and none of the server ones before it
+  uint32_t first = 0;
+  while (first < estimates.size () && estimates[first].first <= seeds[0].time)
+    {
+      first++;
+    }
+  NS_TEST_ASSERT_MSG_LT (first, estimates.size (), "No decision after the switch");
+  double sum = seeds[0].bitrate;
+  uint32_t count = 1;
+  for (uint32_t i = 0; i < samples.size (); i++)
+    {
+      if (samples[i].time > seeds[0].time && samples[i].time <= estimates[first].first)
+        {
+          sum += samples[i].bitrate;
+          count++;
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (estimates[first].second, sum / count, 1e-6 * sum / count,
+                             "The estimate should start over from the seed");
+
+  BitrateLadder::Set (84, 0);
+}
+
+// Checks that deficit round robin gives the connections ready at once a
+// quantum each in turn, and that a connection closed by its peer leaves the
+// schedule of the others.
+class DrrTestCase : public TestCase
+{
+public:
+  DrrTestCase ();
+
+private:
+  // The bytes served to a connection so far, after a send
+  struct Send
+  {
+    Time time;
+    Socket *socket;
+    Ipv4Address peer;
+    uint64_t bytes;
+  };
+
+  virtual void DoRun (void);
+  static void ConnectionTx (std::vector<Send> *sends, Ptr<Socket> socket, uint64_t bytes);
+};
+
+DrrTestCase::DrrTestCase ()
+  : TestCase ("Deficit round robin shares the sends of the ready connections")
+{
+}
+
+void
+DrrTestCase::ConnectionTx (std::vector<Send> *sends, Ptr<Socket> socket, uint64_t bytes)
+{
+  Address peer;
+  socket->GetPeerName (peer);
+  Send send = { Simulator::Now (), PeekPointer (socket), InetSocketAddress::ConvertFrom (peer).GetIpv4 (), bytes };
+  sends->push_back (send);
+}
+
+void
+DrrTestCase::DoRun (void)
+{
+  // 5 segments of 2 s of 500 KB, more than a socket buffer
+  NS_TEST_ASSERT_MSG_EQ (SessionFixture::AssignVideo (86, CreateTempDirFilename ("drr.mpd"), 5, 25,
+                                                      std::vector<uint32_t> (1, 2000000)),
+                         true, "Could not parse the manifest");
+
+  // The clients start together on identical links, so their first
+  // requests arrive at the same instant
+  StarFixture star (3, "10Mbps", "10ms");
+  Ptr<DashServer> server = star.InstallServer (Seconds (0.0), Seconds (65.0));
+  server->SetAttribute ("Scheduler", EnumValue (DashServer::DRR));
+  server->SetAttribute ("Quantum", UintegerValue (3000));
+  std::vector<Send> sends;
+  server->TraceConnectWithoutContext ("ConnectionTx", MakeBoundCallback (&DrrTestCase::ConnectionTx, &sends));
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<DashClient> client = CreateObject<TopRateClient> ();
+      client->SetAttribute ("VideoId", UintegerValue (86));
+      // Sent in parts of exactly the deficit
+      client->SetAttribute ("SegmentResponses", BooleanValue (true));
+      // The last client leaves in the middle of the video
+      star.InstallClient (i, client, Seconds (1.0), Seconds (i == 2 ? 2.0 : 60.0));
+    }
+
+  Simulator::Run ();
+  uint32_t left = star.GetSegments (2);
+  bool stayed = star.GetSegments (0) == 5 && star.GetSegments (1) == 5;
+  Ipv4Address leaving = star.GetClientAddress (2);
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (sends.empty (), false, "Nothing was sent");
+
+  // The first pass, until the sockets are full
+  std::map<Socket *, uint64_t> pass;
+  uint32_t end = 0;
+  while (end < sends.size () && sends[end].time == sends[0].time)
+    {
+      pass[sends[end++].socket] = 0;
+    }
+  NS_TEST_ASSERT_MSG_EQ (pass.size (), 3, "The connections ready at once should share the pass");
+  uint64_t spread = 0;
+  for (uint32_t i = 0; i < end; i++)
+    {
+      pass[sends[i].socket] = sends[i].bytes;
+      uint64_t least = pass.begin ()->second;
+      uint64_t most = least;
+      for (std::map<Socket *, uint64_t>::const_iterator it = pass.begin (); it != pass.end (); ++it)
+        {
+          least = std::min (least, it->second);
+          most = std::max (most, it->second);
+        }
+      spread = std::max (spread, most - least);
+    }
+  NS_TEST_ASSERT_MSG_EQ (spread <= 3000, true, "A connection should never be more than a quantum ahead");
+
+  // Once its FIN arrives the server stops sending to the client that left
+  Time last = Seconds (0);
+  for (uint32_t i = 0; i < sends.size (); i++)
+    {
+      if (sends[i].peer == leaving)
+        {
+          last = sends[i].time;
+        }
+    }
+  NS_TEST_ASSERT_MSG_LT (left, 5, "The last client should leave in the middle of the video");
+  NS_TEST_ASSERT_MSG_LT (last, Seconds (2.5), "The closed connection should leave the schedule");
+  NS_TEST_ASSERT_MSG_EQ (stayed, true, "The other clients should receive every segment");
+
+  BitrateLadder::Set (86, 0);
+}
+
+// Checks that earliest deadline first serves the requests that arrive
+// together in the order of their deadlines, not of their arrival.
+class EdfTestCase : public TestCase
+{
+public:
+  EdfTestCase ();
+
+private:
+  virtual void DoRun (void);
+  static void Connected (Time deadline, Ptr<Socket> socket);
+  static void Drain (Ptr<Socket> socket);
+  static void ConnectionTx (std::vector<std::pair<Time, Ipv4Address> > *sends, Ptr<Socket> socket,
+                            uint64_t bytes);
+};
+
+EdfTestCase::EdfTestCase ()
+  : TestCase ("Earliest deadline first serves the segment played first")
+{
+}
+
+void
+EdfTestCase::Connected (Time deadline, Ptr<Socket> socket)
+{
+  // The first segment, with the deadline a playing client would set
+  HTTPRequestHeader requestHeader;
+  requestHeader.SetDeadline (deadline);
+  Ptr<Packet> packet = Create<Packet> (HTTP_REQUEST_BODY - requestHeader.GetSerializedSize ());
+  packet->AddHeader (requestHeader);
+
+  HTTPHeader httpHeader;
+  httpHeader.SetSeq (1);
+  httpHeader.SetMessageType (HTTP_REQUEST);
+  httpHeader.SetVideoId (87);
+  httpHeader.SetResolution (2000000);
+  httpHeader.SetSegmentId (0);
+  packet->AddHeader (httpHeader);
+  socket->Send (packet);
+}
+
+void
+EdfTestCase::Drain (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+    }
+}
+
+void
+EdfTestCase::ConnectionTx (std::vector<std::pair<Time, Ipv4Address> > *sends, Ptr<Socket> socket,
+                           uint64_t bytes)
+{
+  Address peer;
+  socket->GetPeerName (peer);
+  sends->push_back (std::make_pair (Simulator::Now (), InetSocketAddress::ConvertFrom (peer).GetIpv4 ()));
+}
+
+void
+EdfTestCase::DoRun (void)
+{
+  // A segment of 500 KB, more than a socket buffer
+  NS_TEST_ASSERT_MSG_EQ (SessionFixture::AssignVideo (87, CreateTempDirFilename ("edf.mpd"), 1, 25,
+                                                      std::vector<uint32_t> (1, 2000000)),
+                         true, "Could not parse the manifest");
+
+  // The requests arrive at the same instant, the first client's with the
+  // latest deadline
+  StarFixture star (3, "10Mbps", "10ms");
+  Ptr<DashServer> server = star.InstallServer (Seconds (0.0), Seconds (5.0));
+  server->SetAttribute ("Scheduler", EnumValue (DashServer::EDF));
+  std::vector<std::pair<Time, Ipv4Address> > sends;
+  server->TraceConnectWithoutContext ("ConnectionTx", MakeBoundCallback (&EdfTestCase::ConnectionTx, &sends));
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<Socket> socket = Socket::CreateSocket (star.GetClient (i), TcpSocketFactory::GetTypeId ());
+      socket->Bind ();
+      socket->SetConnectCallback (MakeBoundCallback (&EdfTestCase::Connected, Seconds (10 - i)),
+                                  MakeNullCallback<void, Ptr<Socket> > ());
+      socket->SetRecvCallback (MakeCallback (&EdfTestCase::Drain));
+      Simulator::Schedule (Seconds (1.0), &Socket::Connect, socket, star.GetRemote (i));
+    }
+
+  Simulator::Stop (Seconds (6.0));
+  Simulator::Run ();
+  std::vector<Ipv4Address> clients;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      clients.push_back (star.GetClientAddress (i));
+    }
+  Simulator::Destroy ();
+
+  // The connections of the first pass, in the order they were served,
+  // each until its socket was full
+  std::vector<Ipv4Address> order;
+  for (uint32_t i = 0; i < sends.size () && sends[i].first == sends[0].first; i++)
+    {
+      if (order.empty () || order.back () != sends[i].second)
+        {
+          order.push_back (sends[i].second);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (order.size (), 3, "Each connection should be served once in the pass");
+  NS_TEST_ASSERT_MSG_EQ (order[0], clients[2], "The earliest deadline should be served first");
+  NS_TEST_ASSERT_MSG_EQ (order[1], clients[1], "Wrong second connection");
+  NS_TEST_ASSERT_MSG_EQ (order[2], clients[0], "The latest deadline should be served last");
+
+  BitrateLadder::Set (87, 0);
+}
+
+// Checks that a paced connection sends no faster than its token bucket
+// allows, and that no paced send is left once its peer closes it or the
+// server stops.
+class PacingTestCase : public TestCase
+{
+public:
+  PacingTestCase ();
+
+private:
+  virtual void DoRun (void);
+  static void ConnectionTx (std::map<Ipv4Address, std::vector<std::pair<Time, uint64_t> > > *sends,
+                            Ptr<Socket> socket, uint64_t bytes);
+};
+
+PacingTestCase::PacingTestCase ()
+  : TestCase ("A paced connection is held to its token bucket")
+{
+}
+
+void
+PacingTestCase::ConnectionTx (std::map<Ipv4Address, std::vector<std::pair<Time, uint64_t> > > *sends,
+                              Ptr<Socket> socket, uint64_t bytes)
+{
+  Address peer;
+  socket->GetPeerName (peer);
+  (*sends)[InetSocketAddress::ConvertFrom (peer).GetIpv4 ()].push_back (std::make_pair (Simulator::Now (), bytes));
+}
+
+void
+PacingTestCase::DoRun (void)
+{
+  // 10 segments of 2 s at 1 Mbps, whose frames are smaller than the bucket
+  NS_TEST_ASSERT_MSG_EQ (SessionFixture::AssignVideo (88, CreateTempDirFilename ("pacing.mpd"), 10, 25,
+                                                      std::vector<uint32_t> (1, 1000000)),
+                         true, "Could not parse the manifest");
+
+  // 1.5 Mbps on 10 Mbps links. The server stops in the middle of the video,
+  // after the second client left
+  StarFixture star (2, "10Mbps", "10ms");
+  Ptr<DashServer> server = star.InstallServer (Seconds (0.0), Seconds (8.0));
+  server->SetAttribute ("PacingFactor", DoubleValue (1.5));
+  server->SetAttribute ("BucketDepth", UintegerValue (15000));
+  std::map<Ipv4Address, std::vector<std::pair<Time, uint64_t> > > sends;
+  server->TraceConnectWithoutContext ("ConnectionTx", MakeBoundCallback (&PacingTestCase::ConnectionTx, &sends));
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<DashClient> client = CreateObject<TopRateClient> ();
+      client->SetAttribute ("VideoId", UintegerValue (88));
+      star.InstallClient (i, client, Seconds (1.0), Seconds (i == 1 ? 3.0 : 20.0));
+    }
+
+  // A paced send left behind would retry until the end of time
+  Simulator::Stop (Seconds (1000.0));
+  Simulator::Run ();
+  Time end = Simulator::Now ();
+  std::vector<std::pair<Time, uint64_t> > stayed = sends[star.GetClientAddress (0)];
+  std::vector<std::pair<Time, uint64_t> > left = sends[star.GetClientAddress (1)];
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (stayed.empty (), false, "Nothing was sent");
+  NS_TEST_ASSERT_MSG_EQ (left.empty (), false, "Nothing was sent to the client that left");
+
+  // A burst of the bucket, then 1.5 Mbps
+  double rate = 1.5 * 1000000 / 8;
+  Time first = stayed.front ().first;
+  uint64_t excess = 0;
+  for (uint32_t i = 0; i < stayed.size (); i++)
+    {
+      double allowed = 15000 + rate * (stayed[i].first - first).GetSeconds ();
+      if (stayed[i].second > allowed + 1)
+        {
+          excess = std::max<uint64_t> (excess, stayed[i].second - allowed);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (excess, 0, "The connection sent more than its bucket allows");
+  // Back to back segments keep it close to the pacing rate
+  double achieved = (stayed.back ().second - 15000) / (stayed.back ().first - first).GetSeconds ();
+  NS_TEST_ASSERT_MSG_GT (achieved, 0.8 * rate, "The connection should be sent at about the pacing rate");
+
+  // Nothing is sent once the connection is removed or the server stopped
+  NS_TEST_ASSERT_MSG_LT (left.back ().first, Seconds (3.5), "The closed connection should not be paced");
+  NS_TEST_ASSERT_MSG_LT (stayed.back ().first, Seconds (8.0), "Nothing should be sent after the stop");
+  NS_TEST_ASSERT_MSG_LT (end, Seconds (1000.0), "A paced send was left after the stop");
+
+  BitrateLadder::Set (88, 0);
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -157,6 +2202,32 @@ DashTestSuite::DashTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new DashTestCase1, TestCase::QUICK);
+  AddTestCase (new SegmentCacheTestCase, TestCase::QUICK);
+  AddTestCase (new FrameTraceTestCase, TestCase::QUICK);
+  AddTestCase (new PacketRingTestCase, TestCase::QUICK);
+  AddTestCase (new HttpRequestParserTestCase, TestCase::QUICK);
+  AddTestCase (new MpegPlayerTestCase, TestCase::QUICK);
+  AddTestCase (new AnalyticPlaybackTestCase, TestCase::QUICK);
+  AddTestCase (new SlidingWindowTestCase, TestCase::QUICK);
+  AddTestCase (new ThroughputEstimatorTestCase, TestCase::QUICK);
+  AddTestCase (new BitrateLadderTestCase, TestCase::QUICK);
+  AddTestCase (new MpdFileHandlerTestCase, TestCase::QUICK);
+  AddTestCase (new VideoTimingTestCase, TestCase::QUICK);
+  AddTestCase (new SegmentResponseTestCase, TestCase::QUICK);
+  AddTestCase (new FrameRangeTestCase, TestCase::QUICK);
+  AddTestCase (new CancelTestCase, TestCase::QUICK);
+  AddTestCase (new AbandonTestCase, TestCase::QUICK);
+  AddTestCase (new PipelineTestCase, TestCase::QUICK);
+  AddTestCase (new ChunkTestCase, TestCase::QUICK);
+  AddTestCase (new EdgeSelectorTestCase, TestCase::QUICK);
+  AddTestCase (new ReconnectTestCase, TestCase::QUICK);
+  AddTestCase (new FogReconnectTestCase, TestCase::QUICK);
+  AddTestCase (new ReadSampleRingTestCase, TestCase::QUICK);
+  AddTestCase (new TransportStatsTestCase, TestCase::QUICK);
+  AddTestCase (new TransportColdStartTestCase, TestCase::QUICK);
+  AddTestCase (new DrrTestCase, TestCase::QUICK);
+  AddTestCase (new EdfTestCase, TestCase::QUICK);
+  AddTestCase (new PacingTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite